@@ -0,0 +1,32 @@
+#include "bcd.h"
+#include <Arduino.h>
+
+namespace bcd {
+
+const unsigned long POWERS[BYTES * 2] PROGMEM = {
+  1ul, 10ul, 100ul, 1000ul, 10000ul, 100000ul, 1000000ul, 10000000ul,
+  100000000ul, 1000000000ul};
+
+// At most nine subtractions per digit
+void FromBinary(unsigned long n, Number *out) {
+  for (signed char i = BYTES * 2 - 1; i >= 0; i--) {
+    unsigned char d = 0;
+    unsigned long power = pgm_read_dword(POWERS + i);
+    while (n >= power) {
+      n -= power;
+      d++;
+    }
+    if (i & 1) out->b[i >> 1] = d << 4;
+    else out->b[i >> 1] |= d;
+  }
+}
+
+unsigned long ToBinary(const Number &n) {
+  unsigned long r = 0;
+  for (unsigned char i = 0; i < BYTES * 2; i++) {
+    r += Digit(n, i) * pgm_read_dword(POWERS + i);
+  }
+  return r;
+}
+
+}  // namespace
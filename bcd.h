@@ -0,0 +1,28 @@
+#ifndef UBITX_BCD_H_
+#define UBITX_BCD_H_
+
+namespace bcd {
+
+/**
+ * Packed BCD numbers of ten digits, two per byte with the lower digit in
+ * the low nibble and the lowest digits in b[0]. Digits come out without
+ * a single division, conversions use a table of powers of ten.
+ */
+const unsigned char BYTES = 5;
+
+struct Number {
+  unsigned char b[BYTES];
+};
+
+void FromBinary(unsigned long n, Number *out);
+unsigned long ToBinary(const Number &n);
+
+// Digit i counts 10^i
+inline unsigned char Digit(const Number &n, unsigned char i) {
+  unsigned char b = n.b[i >> 1];
+  return i & 1 ? b >> 4 : b & 0x0f;
+}
+
+}  // namespace
+
+#endif  // UBITX_BCD_H_
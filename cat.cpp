@@ -10,6 +10,11 @@
  */
 #include "cat.h"
 #include <Arduino.h>
+#include "i2c.h"
+#include "perf.h"
+#include "power.h"
+#include "si5351.h"
+#include "swr.h"
 #include "ubitx.h"
 #include "ui.h"
 
@@ -35,84 +40,24 @@ char rx_buffer_check_count = 0;
 char cat[5]; 
 char inside_cat = 0; 
 
-// 18570
-static char SetHighNibble(char b, char v) {
-  // Clear the high nibble
-  b &= 0x0f;
-  // Set the high nibble
-  return b | ((v & 0x0f) << 4);
-}
-
-static char SetLowNibble(char b, char v) {
-  // Clear the low nibble
-  b &= 0xf0;
-  // Set the low nibble
-  return b | (v & 0x0f);
-}
-
-static char GetHighNibble(char b) {
-  return (b >> 4) & 0x0f;
-}
-
-static char GetLowNibble(char b) {
-  return b & 0x0f;
-}
-
-// Takes a number and produces the requested number of decimal digits, staring
-// from the least significant digit.  
-//
-static void GetDecimalDigits(unsigned long number, char* result, int digits) {
-  for (int i = 0; i < digits; i++) {
-    // "Mask off" (in a decimal sense) the LSD and return it
-    result[i] = number % 10;
-    // "Shift right" (in a decimal sense)
-    number /= 10;
+// CAT frequencies are four bytes of BCD in 10 Hz, the highest digits
+// first: [12][34][56][78] = 123.45678 MHz. Our BCD holds the 1 Hz digit
+// too and starts from the low end, so it is a shift by one nibble.
+void WriteFreq(const bcd::Number &f, char* cmd) {
+  for (unsigned char i = 0; i < 4; i++) {
+    cmd[3 - i] = f.b[i + 1] << 4 | f.b[i] >> 4;
   }
 }
 
-// Takes a frequency and writes it into the CAT command buffer in BCD form.
-//
-void WriteFreq(unsigned long freq, char* cmd) {
-  // Convert the frequency to a set of decimal digits. We are taking 9 digits
-  // so that we can get up to 999 MHz. But the protocol doesn't care about the
-  // LSD (1's place), so we ignore that digit.
-  char digits[9];
-  GetDecimalDigits(freq, digits, 9);
-  // Start from the LSB and get each nibble 
-  cmd[3] = SetLowNibble(cmd[3], digits[1]);
-  cmd[3] = SetHighNibble(cmd[3], digits[2]);
-  cmd[2] = SetLowNibble(cmd[2], digits[3]);
-  cmd[2] = SetHighNibble(cmd[2], digits[4]);
-  cmd[1] = SetLowNibble(cmd[1], digits[5]);
-  cmd[1] = SetHighNibble(cmd[1], digits[6]);
-  cmd[0] = SetLowNibble(cmd[0], digits[7]);
-  cmd[0] = SetHighNibble(cmd[0], digits[8]);  
-}
-
-// This function takes a frquency that is encoded using 4 bytes of BCD
-// representation and turns it into an long measured in Hz.
-//
-// [12][34][56][78] = 123.45678? Mhz
-//
 unsigned long ReadFreq(char* cmd) {
-    // Pull off each of the digits
-    char d7 = GetHighNibble(cmd[0]);
-    char d6 = GetLowNibble(cmd[0]);
-    char d5 = GetHighNibble(cmd[1]);
-    char d4 = GetLowNibble(cmd[1]); 
-    char d3 = GetHighNibble(cmd[2]);
-    char d2 = GetLowNibble(cmd[2]); 
-    char d1 = GetHighNibble(cmd[3]);
-    char d0 = GetLowNibble(cmd[3]); 
-    return  
-      (unsigned long)d7 * 100000000L +
-      (unsigned long)d6 * 10000000L +
-      (unsigned long)d5 * 1000000L + 
-      (unsigned long)d4 * 100000L + 
-      (unsigned long)d3 * 10000L + 
-      (unsigned long)d2 * 1000L + 
-      (unsigned long)d1 * 100L + 
-      (unsigned long)d0 * 10L; 
+  bcd::Number f;
+  f.b[0] = 0;
+  for (unsigned char i = 0; i < 4; i++) {
+    unsigned char c = cmd[3 - i];
+    f.b[i] |= c << 4;
+    f.b[i + 1] = c >> 4;
+  }
+  return bcd::ToBinary(f);
 }
 
 void CatReadEeprom() {
@@ -237,6 +182,17 @@ void CatReadEeprom() {
   Serial.write(cat, 2);
 }
 
+// Reply to the frequency and mode poll, only rebuilt after a change
+char status_response[5];
+bool status_stale = true;
+
+void Changed(unsigned char what) {
+  if (what & (ubitx::CHANGED_FREQUENCY | ubitx::CHANGED_MODE | ubitx::CHANGED_VFO |
+              ubitx::CHANGED_TX)) {
+    status_stale = true;
+  }
+}
+
 void ProcessCatCommand(char* cmd) {
   char response[5];
   unsigned long f;
@@ -245,7 +201,6 @@ void ProcessCatCommand(char* cmd) {
     case 0x01:  // set frequency
       f = ReadFreq(cmd);
       ubitx::SetFrequency(f);   
-      ui::UpdateDisplay();
       response[0]=0;
       Serial.write(response, 1);
       break;
@@ -256,27 +211,28 @@ void ProcessCatCommand(char* cmd) {
       ubitx::SplitDisable();
       break;
     case 0x03:
-      WriteFreq(ubitx::frequency, response); // Put the frequency into the buffer
-      response[4] = ubitx::status.is_usb ? 0x01 : 0x00;
-      Serial.write(response, 5);
+      ubitx::DispatchChanges();  // a set just before must show in the reply
+      if (status_stale) {
+        WriteFreq(ubitx::frequency_bcd, status_response);
+        status_response[4] = ubitx::status.is_usb ? 0x01 : 0x00;
+        status_stale = false;
+      }
+      Serial.write(status_response, 5);
       break;
     case 0x07:  // set mode
       ubitx::SidebandSet((cmd[0] == 0x00 || cmd[0] == 0x03) ? 0 : 1);
       response[0] = 0x00;
       Serial.write(response, 1);
-      ui::UpdateDisplay();
       break;   
     case 0x08:  // PTT On
       if (!ubitx::in_tx) {
         response[0] = 0;
         tx_cat = true;
         ubitx::TxStartSsb();
-        ui::UpdateDisplay();
       } else {
         response[0] = 0xf0;
       } 
       Serial.write(response, 1);
-      ui::UpdateDisplay();
       break;
     case 0x88:  // PTT OFF
       if (ubitx::in_tx) {
@@ -285,14 +241,12 @@ void ProcessCatCommand(char* cmd) {
       }
       response[0] = 0;
       Serial.write(response, 1);
-      ui::UpdateDisplay();
       break;
     case 0x81:
       // toggle the VFOs
       response[0] = 0;
       ubitx::VfoSwap(true);
       Serial.write(response, 1);
-      ui::UpdateDisplay();
       break;
   case 0xBB:  // Read FT-817 EEPROM Data  (for comfirtable)
       CatReadEeprom();
@@ -304,8 +258,8 @@ void ProcessCatCommand(char* cmd) {
       Serial.write(response, 1);
       break;
     case 0xf7: {
-      char isHighSWR = 0;
-    
+      char isHighSWR = swr::high_swr;
+
       // Inverted -> *ptt = ((p->tx_status & 0x80) == 0);
       // from souce code in ft817.c (hamlib)
       response[0] = ((ubitx::in_tx ? 0 : 1) << 7) +
@@ -317,6 +271,34 @@ void ProcessCatCommand(char* cmd) {
       Serial.write(response, 1);
       break;
     }
+    case 0xde: {
+      // Not FT-817: the Si5351 registers as last sent, the vco they were
+      // computed for and the synthesizer i2c traffic so far, see
+      // tools/synth_check.py
+      si5351::Image img;
+      si5351::ReadChip(&img);
+      Serial.write((char *)&img, sizeof(img));
+      Serial.write((char *)&si5351::si5351bx_vcoa, sizeof(si5351::si5351bx_vcoa));
+      Serial.write((char *)&i2c::bytes[i2c::PRIO_HIGH], sizeof(i2c::bytes[0]));
+      Serial.write((char *)&i2c::transactions[i2c::PRIO_HIGH], sizeof(i2c::transactions[0]));
+      break;
+    }
+#if PERF_PROFILE
+    case 0xdd:
+      // Not FT-817: profile of section P1 (see perf::Section) as count,
+      // total and max in 4 us ticks, little endian, then the 16 byte
+      // log2 histogram. A single 0 for an unknown section, without
+      // PERF_PROFILE the opcode gets the default reply.
+      if ((unsigned char)cmd[0] < perf::SECTIONS) {
+        perf::Profile p;
+        perf::GetProfile(cmd[0], &p);
+        Serial.write((char *)&p, sizeof(p));
+      } else {
+        response[0] = 0x00;
+        Serial.write(response, 1);
+      }
+      break;
+#endif
     default: 
       // This is debug, remove from final
       //ultoa(*((unsigned long *)cmd), c, 16);
@@ -331,7 +313,14 @@ void ProcessCatCommand(char* cmd) {
   inside_cat = 0;
 }
 
-// main calls run() over and over again
+// CAT runs as an event task: when a whole command is in, when more of
+// one arrived, or to drop a partial one after the timeout
+bool Ready() {
+  int n = Serial.available();
+  return n >= 5 || n != rx_buffer_check_count
+      || (n && rx_buffer_arrive_time < millis());
+}
+
 
 void Run() {
   unsigned char i;
@@ -365,6 +354,7 @@ void Run() {
     return;
   inside_cat = 1;
 
+  power::Activity();
   ProcessCatCommand(cat);
   inside_cat = 0;
 }
@@ -4,6 +4,8 @@
 namespace cat {
 
 extern bool tx_cat;
+bool Ready();
+void Changed(unsigned char what);
 void Run();
 
 }
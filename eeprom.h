@@ -17,7 +17,8 @@ const int CW_SPEED =      21;  // 22       int
 const int VFO_A_USB =     23;  // char
 const int VFO_B_USB =     24;  // char
 const int IAMBIC_KEY =    25;  // char 
-const int CW_DELAY_TIME = 26;  // char 
+const int CW_DELAY_TIME = 26;  // 27       int
+const int SWR_LIMIT =     28;  // char
 }  // namespace
 
 #endif  // EEPROM_H_
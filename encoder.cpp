@@ -1,12 +1,29 @@
 #include "encoder.h"
 #include <Arduino.h>
 #include "hw.h"
+#include "perf.h"
+#include "power.h"
 
 namespace encoder {
 // Code adapted from https://github.com/brianlow/Rotary
 
-// Normal encoder state
-volatile char enc_count = 0;
+// Direction and millis() of each encoder event, filled by the interrupt
+// and drained by Read(). When it is full new events are dropped.
+const unsigned char QUEUE_SIZE = 16;
+char event_dir[QUEUE_SIZE];
+unsigned int event_ms[QUEUE_SIZE];
+volatile unsigned char head = 0;
+volatile unsigned char tail = 0;
+
+// Reader state
+unsigned int last_ms = 0;
+unsigned int last_dt = 0xffff;
+char last_dir = 0;
+char part = 0;                  // events towards the next step
+
+const Curve TUNING PROGMEM = {1, {{40, 1}, {25, 4}, {12, 40}, {0, 500}}};
+const Curve RIT    PROGMEM = {1, {{40, 1}, {20, 5}, {0, 20}, {0, 20}}};
+const Curve MENU   PROGMEM = {2, {{40, 1}, {20, 5}, {0, 25}, {0, 25}}};
 
 // Values returned by 'process'
 #define DIR_NONE 0x0
@@ -23,7 +40,7 @@ volatile char enc_count = 0;
 // Internal state
 unsigned char state = R_START;
 
-const unsigned char ttable[6][4] = {
+const unsigned char ttable[6][4] PROGMEM = {
   {R_START_M,            R_CW_BEGIN,     R_CCW_BEGIN,  R_START}, // R_START (00)
   {R_START_M | DIR_CCW,  R_START,        R_CCW_BEGIN,  R_START}, // R_CCW_BEGIN
   {R_START_M | DIR_CW,   R_CW_BEGIN,     R_START,      R_START}, // R_CW_BEGIN
@@ -39,11 +56,20 @@ const unsigned char ttable[6][4] = {
 ISR(PCINT0_vect) {
   unsigned char pinstate = (PINB & 0b00000110) >> 1;
 
-  state = ttable[state & 0xf][pinstate];
+  state = pgm_read_byte(&ttable[state & 0xf][pinstate]);
+  char dir;
   switch (state & 0x30) {
-    case DIR_CW: enc_count -= 1; break;
-    case DIR_CCW: enc_count += 1; break;
+    case DIR_CW: dir = -1; break;
+    case DIR_CCW: dir = 1; break;
+    default: return;
   }
+  perf::Begin(_BV(perf::KNOB) | _BV(perf::RF) | _BV(perf::DISP));
+  power::Activity();
+  unsigned char h = head;
+  if ((unsigned char)(h - tail) == QUEUE_SIZE) return;
+  event_dir[h & (QUEUE_SIZE - 1)] = dir;
+  event_ms[h & (QUEUE_SIZE - 1)] = millis();
+  head = h + 1;
 }
 
 /*
@@ -61,16 +87,43 @@ void Init(void) {
   PciSetup(hw::ENC_B);
 }
 
-int Read() {
-  int ret = enc_count;
-  enc_count = 0;
-  return ret;
+/*
+ * Steps since the last call, scaled by the curve. The speed is the mean
+ * of the last two event intervals, a change of direction starts slow.
+ */
+int Read(const Curve &curve_P) {
+  Curve curve;
+  memcpy_P(&curve, &curve_P, sizeof(curve));
+  int steps = 0;
+  unsigned char t = tail;
+  while (t != head) {
+    char dir = event_dir[t & (QUEUE_SIZE - 1)];
+    unsigned int ms = event_ms[t & (QUEUE_SIZE - 1)];
+    t++;
+    unsigned int dt = ms - last_ms;
+    last_ms = ms;
+    if (dir != last_dir) {
+      last_dir = dir;
+      last_dt = dt = 0xffff;
+      part = 0;
+    }
+    unsigned int speed = (dt >> 1) + (last_dt >> 1);
+    last_dt = dt;
+    part += dir;
+    if (part != (char)curve.events && part != -(char)curve.events) continue;
+    part = 0;
+    const Accel *a = curve.accel;
+    while (speed < a->min_ms) a++;
+    steps += dir * (int)a->mult;
+  }
+  tail = t;
+  return steps;
 }
 
+// One step per detent and no acceleration, for picking from lists
 int ReadSlow() {
-  int ret = enc_count / 2;
-  if (ret) enc_count = 0;
-  return ret;
+  static const Curve DETENT PROGMEM = {2, {{0, 1}}};
+  return Read(DETENT);
 }
 
 } // namespace
@@ -1,10 +1,32 @@
 #ifndef ENCODER_H_
 #define ENCODER_H_
 
+#include <avr/pgmspace.h>
+
 namespace encoder {
 
+/**
+ * Maps how fast the knob turns to how far it moves. Each encoder event
+ * (two per detent) is timed in the interrupt, so the speed does not
+ * depend on how often the main loop gets around to reading it.
+ */
+struct Accel {
+  unsigned char min_ms;     // events at least this far apart ...
+  unsigned int mult;        // ... count this many steps
+};
+
+struct Curve {
+  unsigned char events;     // encoder events per step, 2 is one per detent
+  Accel accel[4];           // slowest first, the last one has min_ms 0
+};
+
+// Curves are kept in flash
+extern const Curve TUNING PROGMEM;  // 50 Hz steps, a quarter turn crosses a band
+extern const Curve RIT PROGMEM;     // 10 Hz steps
+extern const Curve MENU PROGMEM;    // menu values, one step per detent when slow
+
 void Init(void);
-int Read();
+int Read(const Curve &curve_P);
 int ReadSlow();
 
 }  // namespace
@@ -0,0 +1,114 @@
+// Generated by tools/gen_fonts.py from tools/glyphs.txt, do not edit.
+// 1376 bytes of flash.
+#ifndef UBITX_FONTS_GEN_H_
+#define UBITX_FONTS_GEN_H_
+
+#include <avr/pgmspace.h>
+
+namespace fonts {
+
+const unsigned char MAP_FIRST = 32;
+const unsigned char MAP_SIZE = 64;
+const unsigned char NONE = 0xff;
+
+//  %+-./0123456789:=>ABCDEFGHIJKLMNOPQRSTUVWXYZ: glyph - MAP_FIRST to slot, 16 bytes per slot, top tile first
+const uint8_t TEXT_MAP[] PROGMEM = {
+  0x00, 0xff, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0x02, 0xff, 0x03, 0x04, 0x05,
+  0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0xff, 0xff, 0x11, 0x12, 0xff,
+  0xff, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21,
+  0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+const uint8_t TEXT[] PROGMEM = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x0f, 0x0f, 0xc0, 0xf0, 0x3c, 0x0f, 0x00, 0x00, 0x3c, 0x0f, 0x03, 0x00, 0x3c, 0x3c, 0x00,
+  0x00, 0xc0, 0xc0, 0xfc, 0xfc, 0xc0, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x0f, 0x00, 0x00, 0x00,
+  0x00, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3c, 0x3c, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0xc0, 0xf0, 0x3c, 0x0c, 0x00, 0x30, 0x3c, 0x0f, 0x03, 0x00, 0x00, 0x00,
+  0x00, 0xfc, 0xff, 0xc3, 0x33, 0xff, 0xfc, 0x00, 0x00, 0x0f, 0x3f, 0x30, 0x30, 0x3f, 0x0f, 0x00,
+  0x00, 0x00, 0x0c, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x3f, 0x3f, 0x30, 0x30, 0x00,
+  0x00, 0x0c, 0x0f, 0x03, 0xc3, 0xff, 0x3c, 0x00, 0x00, 0x3c, 0x3f, 0x33, 0x30, 0x30, 0x30, 0x00,
+  0x00, 0x0c, 0x0f, 0xc3, 0xc3, 0xff, 0x3c, 0x00, 0x00, 0x0c, 0x3c, 0x30, 0x30, 0x3f, 0x0f, 0x00,
+  0x00, 0xc0, 0xc0, 0x30, 0x3c, 0xff, 0xff, 0x00, 0x00, 0x03, 0x03, 0x03, 0x03, 0x3f, 0x3f, 0x03,
+  0x00, 0x3f, 0x3f, 0x33, 0x33, 0xf3, 0xc3, 0x00, 0x00, 0x0c, 0x3c, 0x30, 0x30, 0x3f, 0x0f, 0x00,
+  0x00, 0xfc, 0xff, 0xc3, 0xc3, 0xcf, 0x0c, 0x00, 0x00, 0x0f, 0x3f, 0x30, 0x30, 0x3f, 0x0f, 0x00,
+  0x00, 0x0f, 0x0f, 0xc3, 0xf3, 0x3f, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f, 0x00, 0x00, 0x00,
+  0x00, 0x3c, 0xff, 0xc3, 0xc3, 0xff, 0x3c, 0x00, 0x00, 0x0f, 0x3f, 0x30, 0x30, 0x3f, 0x0f, 0x00,
+  0x00, 0x3c, 0xff, 0xc3, 0xc3, 0xff, 0xfc, 0x00, 0x00, 0x0c, 0x3c, 0x30, 0x30, 0x3f, 0x0f, 0x00,
+  0x00, 0x00, 0x00, 0x30, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c, 0x00, 0x00, 0x00,
+  0x00, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x00, 0x00, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x00,
+  0x00, 0x03, 0x03, 0x0f, 0x3c, 0xf0, 0xc0, 0x00, 0x00, 0x30, 0x30, 0x3c, 0x0f, 0x03, 0x00, 0x00,
+  0x00, 0xf0, 0xfc, 0xcf, 0xcf, 0xfc, 0xf0, 0x00, 0x00, 0x3f, 0x3f, 0x00, 0x00, 0x3f, 0x3f, 0x00,
+  0x00, 0xff, 0xff, 0xc3, 0xc3, 0xff, 0x3c, 0x00, 0x00, 0x3f, 0x3f, 0x30, 0x30, 0x3f, 0x0f, 0x00,
+  0x00, 0xfc, 0xff, 0x03, 0x03, 0x0f, 0x0c, 0x00, 0x00, 0x0f, 0x3f, 0x30, 0x30, 0x3c, 0x0c, 0x00,
+  0x00, 0xff, 0xff, 0x03, 0x0f, 0xfc, 0xf0, 0x00, 0x00, 0x3f, 0x3f, 0x30, 0x3c, 0x0f, 0x03, 0x00,
+  0x00, 0xff, 0xff, 0xc3, 0xc3, 0x03, 0x03, 0x00, 0x00, 0x3f, 0x3f, 0x30, 0x30, 0x30, 0x30, 0x00,
+  0x00, 0xff, 0xff, 0xc3, 0xc3, 0x03, 0x03, 0x00, 0x00, 0x3f, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0xfc, 0xff, 0x03, 0xc3, 0xcf, 0xcc, 0x00, 0x00, 0x0f, 0x3f, 0x30, 0x30, 0x3f, 0x0f, 0x00,
+  0x00, 0xff, 0xff, 0xc0, 0xc0, 0xff, 0xff, 0x00, 0x00, 0x3f, 0x3f, 0x00, 0x00, 0x3f, 0x3f, 0x00,
+  0x00, 0x00, 0x03, 0xff, 0xff, 0x03, 0x00, 0x00, 0x00, 0x00, 0x30, 0x3f, 0x3f, 0x30, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x03, 0xff, 0xff, 0x03, 0x00, 0x00, 0x0c, 0x3c, 0x30, 0x3f, 0x0f, 0x00, 0x00,
+  0x00, 0xff, 0xff, 0xf0, 0x3c, 0x0f, 0x03, 0x00, 0x00, 0x3f, 0x3f, 0x03, 0x0f, 0x3c, 0x30, 0x00,
+  0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f, 0x30, 0x30, 0x30, 0x30, 0x00,
+  0x00, 0xff, 0xff, 0x3c, 0xf0, 0x3c, 0xff, 0xff, 0x00, 0x3f, 0x3f, 0x00, 0x00, 0x00, 0x3f, 0x3f,
+  0x00, 0xff, 0xff, 0xfc, 0xf0, 0xff, 0xff, 0x00, 0x00, 0x3f, 0x3f, 0x00, 0x03, 0x3f, 0x3f, 0x00,
+  0x00, 0xfc, 0xff, 0x03, 0x03, 0xff, 0xfc, 0x00, 0x00, 0x0f, 0x3f, 0x30, 0x30, 0x3f, 0x0f, 0x00,
+  0x00, 0xff, 0xff, 0xc3, 0xc3, 0xff, 0x3c, 0x00, 0x00, 0x3f, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0xfc, 0xff, 0x03, 0x03, 0xff, 0xfc, 0x00, 0x00, 0x03, 0x0f, 0x0c, 0x3c, 0x3f, 0x33, 0x00,
+  0x00, 0xff, 0xff, 0xc3, 0xc3, 0xff, 0x3c, 0x00, 0x00, 0x3f, 0x3f, 0x03, 0x0f, 0x3c, 0x30, 0x00,
+  0x00, 0x3c, 0xff, 0xc3, 0xc3, 0xcf, 0x0c, 0x00, 0x00, 0x0c, 0x3c, 0x30, 0x30, 0x3f, 0x0f, 0x00,
+  0x00, 0x03, 0x03, 0xff, 0xff, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f, 0x00, 0x00, 0x00,
+  0x00, 0xff, 0xff, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x0f, 0x3f, 0x30, 0x30, 0x3f, 0x0f, 0x00,
+  0x00, 0xff, 0xff, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x03, 0x0f, 0x3c, 0x3c, 0x0f, 0x03, 0x00,
+  0x00, 0xff, 0xff, 0x00, 0xc0, 0x00, 0xff, 0xff, 0x00, 0x3f, 0x3f, 0x0f, 0x03, 0x0f, 0x3f, 0x3f,
+  0x00, 0x0f, 0x3f, 0xf0, 0xf0, 0x3f, 0x0f, 0x00, 0x00, 0x3c, 0x3f, 0x03, 0x03, 0x3f, 0x3c, 0x00,
+  0x00, 0x3f, 0xff, 0xc0, 0xc0, 0xff, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f, 0x00, 0x00, 0x00,
+  0x00, 0x03, 0x03, 0xc3, 0xf3, 0x3f, 0x0f, 0x00, 0x00, 0x3c, 0x3f, 0x33, 0x30, 0x30, 0x30, 0x00,
+};
+
+// -0123456789: glyph - MAP_FIRST to slot, 48 bytes per slot, tiles row by row
+const uint8_t DIGIT_MAP[] PROGMEM = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0xff, 0xff,
+  0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+const uint8_t DIGIT[] PROGMEM = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c, 0x0c, 0x0c, 0x0c, 0x0c, 0x0c, 0x0c, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0xf0, 0xf8, 0xfc, 0x0e, 0x06, 0x06, 0x06, 0x06, 0x0e, 0xfc, 0xf8, 0xf0, 0x00, 0x00,
+  0x00, 0x00, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0x00, 0x00,
+  0x00, 0x00, 0x07, 0x0f, 0x1f, 0x38, 0x30, 0x30, 0x30, 0x30, 0x38, 0x1f, 0x0f, 0x07, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x30, 0x18, 0x18, 0x0c, 0xfe, 0xfe, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x30, 0x3f, 0x3f, 0x3f, 0x30, 0x30, 0x30, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x30, 0x38, 0x3c, 0x0e, 0x06, 0x06, 0x06, 0x06, 0x0e, 0xfc, 0xf8, 0xf0, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x80, 0xc0, 0xe0, 0xf0, 0x78, 0x3c, 0x1e, 0x0f, 0x07, 0x03, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x3f, 0x3f, 0x3f, 0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x00, 0x00,
+  0x00, 0x00, 0x10, 0x18, 0x1c, 0x0e, 0x06, 0x06, 0x06, 0x06, 0x0e, 0xfc, 0xf8, 0xf0, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06, 0x06, 0x06, 0x0f, 0xff, 0xf9, 0xf0, 0x00, 0x00,
+  0x00, 0x00, 0x06, 0x0e, 0x1e, 0x38, 0x30, 0x30, 0x30, 0x30, 0x38, 0x1f, 0x0f, 0x07, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0, 0xf0, 0xfc, 0xfe, 0xfe, 0xfe, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0xe0, 0xf0, 0xfc, 0xdf, 0xcf, 0xc3, 0xc0, 0xff, 0xff, 0xff, 0xc0, 0xc0, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f, 0x3f, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0xfe, 0xfe, 0xfe, 0x06, 0x86, 0x86, 0x86, 0x86, 0x86, 0x86, 0x06, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x03, 0xff, 0xff, 0xfc, 0x00, 0x00,
+  0x00, 0x00, 0x06, 0x0e, 0x1e, 0x38, 0x30, 0x30, 0x30, 0x30, 0x38, 0x1f, 0x0f, 0x07, 0x00, 0x00,
+  0x00, 0x00, 0xf0, 0xf8, 0xfc, 0x0e, 0x06, 0x06, 0x06, 0x06, 0x0e, 0x1c, 0x18, 0x10, 0x00, 0x00,
+  0x00, 0x00, 0xff, 0xff, 0xff, 0x06, 0x03, 0x03, 0x03, 0x03, 0x07, 0xff, 0xfe, 0xf8, 0x00, 0x00,
+  0x00, 0x00, 0x07, 0x0f, 0x1f, 0x38, 0x30, 0x30, 0x30, 0x30, 0x38, 0x1f, 0x0f, 0x07, 0x00, 0x00,
+  0x00, 0x00, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x86, 0xe6, 0xfe, 0x7e, 0x1e, 0x06, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf8, 0xfe, 0xff, 0x07, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0xf8, 0xfc, 0xfe, 0x06, 0x06, 0x06, 0x06, 0xfe, 0xfc, 0xf8, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0xf8, 0xfc, 0xff, 0x07, 0x03, 0x03, 0x03, 0x03, 0x07, 0xff, 0xfc, 0xf8, 0x00, 0x00,
+  0x00, 0x00, 0x07, 0x0f, 0x1f, 0x38, 0x30, 0x30, 0x30, 0x30, 0x38, 0x1f, 0x0f, 0x07, 0x00, 0x00,
+  0x00, 0x00, 0xf0, 0xf8, 0xfc, 0x0e, 0x06, 0x06, 0x06, 0x06, 0x0e, 0xfc, 0xf8, 0xf0, 0x00, 0x00,
+  0x00, 0x00, 0x0f, 0x3f, 0x7f, 0x70, 0x60, 0x60, 0x60, 0x60, 0x30, 0xff, 0xff, 0xff, 0x00, 0x00,
+  0x00, 0x00, 0x04, 0x0c, 0x1c, 0x38, 0x30, 0x30, 0x30, 0x30, 0x38, 0x1f, 0x0f, 0x07, 0x00, 0x00,
+};
+
+}  // namespace
+
+#endif  // UBITX_FONTS_GEN_H_
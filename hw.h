@@ -40,6 +40,9 @@ const int FBUTTON      = A2; // PINC 2 input PC2
 const int PTT          = A3; // PINC 3 input PC3
 const int ANALOG_KEYER = A6; // PINC 6 input PC6
 const int ANALOG_V     = A7; // PINC 7 input PC7
+const int SWR_FWD      = A0; // PINC 0, directional coupler forward voltage
+const int SWR_REF      = A1; // PINC 1, reflected voltage
+const int SMETER       = A6; // PINC 6, AGC / S-meter voltage, the keyer does not read A6 yet
 
 // examples
 // PORTD &= ~(1<<PD4 | 1<<PD5);  // A, B off
@@ -0,0 +1,185 @@
+#include "i2c.h"
+#include <Arduino.h>
+#include "perf.h"
+
+namespace i2c {
+
+// Every queued transaction is kept as [addr][len][data ...] in a ring.
+// Begin() .. End() fills a record and only End() publishes it by moving
+// head, the TWI interrupt frees the bytes by moving tail as it sends them.
+// Ring sizes are powers of two and the indices run free over 0..255, so
+// head - tail is always the number of bytes in use.
+struct Queue {
+  unsigned char *buf;
+  unsigned char mask;
+  volatile unsigned char head;    // end of the last published record
+  volatile unsigned char tail;    // next byte the interrupt will send
+};
+
+unsigned char high_buf[MAX_HIGH + 2];
+unsigned char low_buf[MAX_LOW + 2];
+Queue queues[2] = {{high_buf, MAX_HIGH + 1}, {low_buf, MAX_LOW + 1}};
+
+unsigned int errors = 0;
+unsigned long bytes[2];
+unsigned int transactions[2];
+
+// Record being built by Begin() / Write() / End()
+Queue *open_queue;
+unsigned char open_wr;                // write index
+unsigned char open_len;               // data bytes so far
+bool open_oversized;                  // Write() had no room left for a byte
+
+// Record being sent by the interrupt, 0 while the bus is idle
+Queue * volatile sending = 0;
+unsigned char tx_addr;
+unsigned char tx_left;                // data bytes still to send
+
+// Bit rate per device, everything else runs at the default
+#define TWBR_FOR(hz) ((F_CPU / (hz) - 16) / 2)
+const unsigned char TWBR_DEFAULT = TWBR_FOR(400000UL);
+
+struct Clock {
+  unsigned char addr;
+  unsigned char twbr;
+};
+Clock clocks[2];
+unsigned char clock_count = 0;
+
+unsigned char TwbrFor(unsigned char addr) {
+  for (unsigned char i = 0; i < clock_count; i++) {
+    if (clocks[i].addr == addr) return clocks[i].twbr;
+  }
+  return TWBR_DEFAULT;
+}
+
+// Start the next published record, synthesizer traffic first. Runs in the
+// interrupt or with the bus idle and interrupts off.
+void StartNext() {
+  Queue *q = &queues[PRIO_HIGH];
+  if (q->head == q->tail) {
+    q = &queues[PRIO_LOW];
+    if (q->head == q->tail) {
+      sending = 0;
+      TWCR = _BV(TWEN);               // bus idle, interrupt off
+      return;
+    }
+  }
+  unsigned char t = q->tail;
+  tx_addr = q->buf[t++ & q->mask];
+  tx_left = q->buf[t++ & q->mask];
+  q->tail = t;
+  sending = q;
+  TWBR = TwbrFor(tx_addr);
+  TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+}
+
+ISR(TWI_vect) {
+  Queue *q = sending;
+  switch (TWSR & 0xF8) {
+    case 0x08:                        // START sent
+      TWDR = tx_addr << 1;
+      TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+      return;
+    case 0x18:                        // SLA+W acked
+    case 0x28:                        // data byte acked
+      if (tx_left) {
+        tx_left--;
+        TWDR = q->buf[q->tail & q->mask];
+        q->tail++;
+        TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+        return;
+      }
+      break;
+    default:                          // NACK or bus error, drop the record
+      q->tail += tx_left;
+      errors++;
+  }
+  TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN);
+  while (TWCR & _BV(TWSTO)) {}        // about one SCL period
+  if (q == &queues[PRIO_HIGH] && q->head == q->tail) perf::BusIdle();
+  StartNext();
+}
+
+void Init() {
+  PORTC |= _BV(4) | _BV(5);           // weak pull-ups on SDA / SCL
+  TWSR = 0;                           // prescaler 1
+  TWBR = TWBR_DEFAULT;
+  TWCR = _BV(TWEN);
+}
+
+void SetClock(unsigned char addr, unsigned long hz) {
+  unsigned char i = 0;
+  while (i < clock_count && clocks[i].addr != addr) i++;
+  if (i == sizeof(clocks) / sizeof(clocks[0])) return;
+  if (i == clock_count) clock_count++;
+  clocks[i].addr = addr;
+  clocks[i].twbr = TWBR_FOR(hz);
+}
+
+// Wait for n free bytes in the open queue. Only blocks when the queue
+// is full, the interrupt keeps draining it meanwhile.
+// Waits for the interrupt to free n bytes, which needs interrupts on
+void Reserve(unsigned char n) {
+  while ((unsigned char)(open_queue->mask + 1 - (unsigned char)(open_wr - open_queue->tail)) < n) {}
+}
+
+void Begin(unsigned char addr, unsigned char prio) {
+  open_queue = &queues[prio];
+  open_wr = open_queue->head;
+  open_len = 0;
+  open_oversized = false;
+  Reserve(2);
+  open_queue->buf[open_wr & open_queue->mask] = addr;
+  open_wr += 2;                       // length is filled in by End()
+}
+
+void Write(unsigned char b) {
+  if (open_len == open_queue->mask - 1) {  // longer than the queue
+    open_oversized = true;
+    return;
+  }
+  Reserve(1);
+  open_queue->buf[open_wr++ & open_queue->mask] = b;
+  open_len++;
+}
+
+// A truncated record would put wrong data into the device, so it goes
+// nowhere; head stays put and the bytes written so far are reused
+bool End() {
+  if (open_oversized) {
+    errors++;
+    return false;
+  }
+  open_queue->buf[(open_queue->head + 1) & open_queue->mask] = open_len;
+  unsigned char prio = open_queue - queues;
+  bytes[prio] += open_len + 1;
+  transactions[prio]++;
+  unsigned char sreg = SREG;
+  cli();
+  open_queue->head = open_wr;
+  if (!sending) StartNext();
+  SREG = sreg;
+  return true;
+}
+
+bool Busy() {
+  return sending;
+}
+
+// Anything of this priority queued or still on the wire
+bool Sending(unsigned char prio) {
+  return sending == &queues[prio] || queues[prio].head != queues[prio].tail;
+}
+
+// Room left in a queue, a record takes its data and two bytes more
+unsigned char Free(unsigned char prio) {
+  Queue *q = &queues[prio];
+  return q->mask + 1 - (unsigned char)(q->head - q->tail);
+}
+
+void Flush() {
+  while (sending) {}
+}
+
+}  // namespace
@@ -0,0 +1,43 @@
+#ifndef UBITX_I2C_H_
+#define UBITX_I2C_H_
+
+namespace i2c {
+
+/**
+ * Interrupt driven I2C master shared by the Si5351 and the OLED.
+ * Callers queue a write transaction and return immediately, the TWI
+ * interrupt sends it in the background. Transactions in the high
+ * priority queue are sent before any waiting low priority ones, so a
+ * retune never waits behind a screen redraw.
+ */
+const unsigned char PRIO_HIGH = 0;  // synthesizer
+const unsigned char PRIO_LOW  = 1;  // display
+
+// Longest transaction (data bytes) each queue can take
+const unsigned char MAX_HIGH = 62;
+const unsigned char MAX_LOW  = 126;
+
+extern unsigned int errors;  // transactions dropped after a NACK or oversized
+// Traffic queued so far per priority, address byte included
+extern unsigned long bytes[2];
+extern unsigned int transactions[2];
+
+void Init();
+void SetClock(unsigned char addr, unsigned long hz);
+
+// Begin() and Write() spin until the interrupt has sent enough of the
+// queue to make room, so they must never run with interrupts off or from
+// an interrupt handler. A record longer than MAX_HIGH / MAX_LOW is not
+// sent at all: End() drops it, counts it in errors and returns false.
+// Longer bursts have to be split by the caller.
+void Begin(unsigned char addr, unsigned char prio);
+void Write(unsigned char b);
+bool End();
+bool Busy();
+bool Sending(unsigned char prio);
+unsigned char Free(unsigned char prio);
+void Flush();
+
+}  // namespace
+
+#endif  // UBITX_I2C_H_
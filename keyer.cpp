@@ -38,14 +38,14 @@ char keyer_control;
 unsigned long cw_timeout = 0;  //milliseconds to go before the cw transmit line is released and the radio goes back to rx mode
 
  //CW ADC Range
-int cw_adc_st_from = 0;
-int cw_adc_st_to = 50;
-int cw_adc_both_from = 51;
-int cw_adc_both_to = 300;
-int cw_adc_dot_from = 301;
-int cw_adc_dot_to = 600;
-int cw_adc_dash_from = 601;
-int cw_adc_dash_to = 800;
+const int cw_adc_st_from = 0;
+const int cw_adc_st_to = 50;
+const int cw_adc_both_from = 51;
+const int cw_adc_both_to = 300;
+const int cw_adc_dot_from = 301;
+const int cw_adc_dot_to = 600;
+const int cw_adc_dash_from = 601;
+const int cw_adc_dash_to = 800;
 
 char delay_before_cw_start_time = 50;
 
@@ -63,7 +63,10 @@ char delay_before_cw_start_time = 50;
 void CwKeydown() {
   key_down = 1;  //tracks the CW_KEY
   tone(hw::CW_TONE, ubitx::settings.cw_side_tone); 
-  digitalWrite(hw::CW_KEY, 1);
+  unsigned char sreg = SREG;
+  cli();  // no swr trip between the test and the key
+  if (!ubitx::status.tx_inhibit) digitalWrite(hw::CW_KEY, 1);
+  SREG = sreg;
 
   cw_timeout = millis() + ubitx::settings.cw_delay_time * 10;  
 }
@@ -129,6 +132,8 @@ char UpdatePaddleLatch(char isUpdateKeyState) {
 void CwKeyerIambic() {
   char tmp_keyer_control = 0;
 
+  // Runs until it has to wait for the element or the space to end, the
+  // scheduler calls again a millisecond later
   while (1) {
     switch (keyerState) {
       case IDLE:
@@ -183,10 +188,11 @@ void CwKeyerIambic() {
           CwKeyUp();
           ktimer = millis() + ubitx::settings.cw_speed;  // inter-element time
           keyerState = INTER_ELEMENT;  // next state
-        } else if (keyer_control & IAMBICB) {
-          UpdatePaddleLatch(1);  // early paddle latch in Iambic B mode
+          break;
         }
-        break;
+        if (keyer_control & IAMBICB)
+          UpdatePaddleLatch(1);  // early paddle latch in Iambic B mode
+        return;
       case INTER_ELEMENT:  // Insert time between dits/dahs
         UpdatePaddleLatch(1);  // latch paddle state
         if (millis() > ktimer) {  // are we at end of inter-space ?
@@ -197,37 +203,33 @@ void CwKeyerIambic() {
             keyer_control &= ~(DAH_L);  // clear dah latch
             keyerState = IDLE;  // go idle
           }
+          break;
         }
-        break;
+        return;
     }
   }
 }
 
+// One look at the key per call, the scheduler calls every millisecond
 void CwKeyerStraight() {
-  while(1) {
-    if (UpdatePaddleLatch(0) == DIT_L) {
-      // if we are here, it is only because the key is pressed
-      if (!ubitx::in_tx) {
-        //DelayTime Option
-        ubitx::ActiveDelay(delay_before_cw_start_time * 2);
-        
-        key_down = 0;
-        cw_timeout = millis() + ubitx::settings.cw_delay_time * 10;
-        ubitx::TxStartCw();
-      }
-      CwKeydown();
-      
-      while (UpdatePaddleLatch(0) == DIT_L) {}
-        
-      CwKeyUp();
-    } else {
-      if (0 < cw_timeout && cw_timeout < millis()) {
-        cw_timeout = 0;
-        key_down = 0;
-        ubitx::TxStop();
-      }
-      return;                   //Tx stop control by Main Loop
+  if (UpdatePaddleLatch(0) == DIT_L) {
+    // if we are here, it is only because the key is pressed
+    if (!ubitx::in_tx) {
+      //DelayTime Option
+      ubitx::ActiveDelay(delay_before_cw_start_time * 2);
+
+      key_down = 0;
+      cw_timeout = millis() + ubitx::settings.cw_delay_time * 10;
+      ubitx::TxStartCw();
     }
+    if (!key_down) CwKeydown();
+    return;
+  }
+  if (key_down) CwKeyUp();
+  if (0 < cw_timeout && cw_timeout < millis()) {
+    cw_timeout = 0;
+    key_down = 0;
+    ubitx::TxStop();
   }
 }
 
@@ -3,76 +3,105 @@
 #include "cat.h"
 #include "encoder.h"
 #include "hw.h"
+#include "i2c.h"
 #include "keyer.h"
 #include "menu.h"
+#include "perf.h"
+#include "power.h"
+#include "sched.h"
+#include "swr.h"
 #include "ubitx.h"
 #include "ui.h"
+#include "watchdog.h"
 
 namespace mainloop {
 
 Buttons buttons;
-unsigned long FBTN_HOLD_TIMEOUT = 500;
+
+// Button timing, all in ms
+const unsigned char DEBOUNCE = 5;         // stable samples to change state
+const unsigned int FBTN_HOLD_TIMEOUT = 500;
+const unsigned int DOUBLE_CLICK = 300;    // release to release
+const unsigned char FBTN_RESET_MS = 50;   // held at power-up to reset
 
 void (*DoActiveApp)();
 
-// returns 1 if the button is pressed
-// handles debounce
+// For the reset check in setup(), before the sampling runs. Down only if
+// every read over FBTN_RESET_MS says so, a bounce or a glitch while the
+// supply comes up must not wipe the settings.
 bool FBtnDown() {
-  bool now = false, prev = false;
-  int i = 0;
-
-  do {
-    now = (PINC & PC2_FBUTTON) == 0; // 0 means button short to ground
-    if (prev != now) {
-      prev = now;
-      i = 0;
-    }
-  } while (i++ < debounce_count);
-
-  return now;
+  for (unsigned char i = 0; i < FBTN_RESET_MS; i++) {
+    if (PINC & PC2_FBUTTON) return false;  // 0 means button short to ground
+    delay(1);
+  }
+  return true;
 }
 
-bool PttDown() {
-  bool now = false, prev = false;
-  int i = 0;
-
-  do {
-    now = (PINC & PC3_PTT) == 0; // 0 means button short to ground
-    if (prev != now) {
-      prev = now;
-      i = 0;
-    }
-  } while (i++ < debounce_count);
-
-  return now;
+// Integrator per button: counts up while pressed, down while released and
+// only flips the state at either end, so bounces shorter than DEBOUNCE
+// samples never show.
+unsigned char integrator[2];
+unsigned char debounced = 0;              // bit per button
+unsigned int f_down_ms = 0;
+unsigned int since_click = DOUBLE_CLICK;
+
+bool Integrate(unsigned char i, bool pressed) {
+  if (pressed) {
+    if (integrator[i] < DEBOUNCE && ++integrator[i] == DEBOUNCE) debounced |= _BV(i);
+  } else {
+    if (integrator[i] && --integrator[i] == 0) debounced &= ~_BV(i);
+  }
+  return debounced & _BV(i);
 }
-    
-void CheckButtons() {
-  static unsigned long hold_time = 0;
-  static bool held_dispatched = false;
 
-  bool prev_f_down = buttons.f_down;
-  buttons.f_down = FBtnDown();
-
-  if (buttons.f_down == true) {
-    unsigned long now = millis();
-    if (prev_f_down == false) // pushing button down
-      hold_time = now + FBTN_HOLD_TIMEOUT;
-
-    if (!held_dispatched && hold_time && now > hold_time) { // time passed
+/**
+ * Samples the buttons every ms on Timer0's compare match, Timer0 keeps
+ * counting millis() on its overflow as before. Publishes the states and
+ * the events into buttons, the apps clear the events they consume.
+ * A click is reported on release, a second click within DOUBLE_CLICK
+ * also sets f_double_clicked.
+ */
+ISR(TIMER0_COMPA_vect) {
+  unsigned int prof = perf::Enter();
+  unsigned char pins = PINC;  // 0 means button short to ground
+  bool f = Integrate(0, !(pins & PC2_FBUTTON));
+  bool ptt = Integrate(1, !(pins & PC3_PTT));
+
+  if (since_click < DOUBLE_CLICK) since_click++;
+  if (f) {
+    if (!buttons.f_down) {
+      buttons.f_down = true;
+      buttons.f_pressed = true;
+      f_down_ms = 0;
+      power::Activity();
+    } else if (f_down_ms < FBTN_HOLD_TIMEOUT && ++f_down_ms == FBTN_HOLD_TIMEOUT) {
       buttons.f_held = true;
-      held_dispatched = true;
+    }
+  } else if (buttons.f_down) {
+    buttons.f_down = false;
+    buttons.f_released = true;
+    if (f_down_ms < FBTN_HOLD_TIMEOUT) {
+      buttons.f_clicked = true;
+      if (since_click < DOUBLE_CLICK) {
+        buttons.f_double_clicked = true;
+        since_click = DOUBLE_CLICK;       // a third click starts over
+      } else {
+        since_click = 0;
+      }
     }
   }
 
-  if (buttons.f_down == false) {
-    if (prev_f_down == true && !held_dispatched) // releasing button
-      buttons.f_clicked = true;
-    hold_time = 0;
-    held_dispatched = false;
+  if (ptt != buttons.ptt_down) {
+    buttons.ptt_down = ptt;
+    if (ptt) perf::Begin(_BV(perf::PTT));
+    power::Activity();
   }
+  perf::Leave(perf::P_BUTTONS, prof);
+}
 
-  buttons.ptt_down = PttDown();
+void InitButtons() {
+  OCR0A = 0x80;             // anywhere in the count, the rate is what matters
+  TIMSK0 |= _BV(OCIE0A);
 }
 
 /**
@@ -99,7 +128,7 @@ void DoTx() {
         DoActiveApp = DoTuning;
         break;
       }
-      // TODO update power/swr readings here
+      swr::Draw();
       break;
   }
 }
@@ -117,12 +146,10 @@ void DoTuning() {
 
   switch (state) {
     case STATE_INITIAL:
-      ui::UpdateDisplay();
+      ui::RequestUpdate();
       state = STATE_LOOP;
       break;
     case STATE_LOOP: // loop
-      ui::UpdateVoltage();
-
       if (buttons.f_clicked) { // enter the menu
         buttons.f_clicked = false;
         state = STATE_INITIAL;
@@ -137,7 +164,6 @@ void DoTuning() {
         } else {
           ubitx::VfoCopy(/*save=*/true);
         }
-        ui::UpdateDisplay();
         break;
       }
 
@@ -149,20 +175,22 @@ void DoTuning() {
         break;
       }
 
-      int knob = encoder::Read();
-      if (knob == 0) break;
+      int knob;
       if (ubitx::status.shift_mode == ubitx::SHIFT_RIT) {
         // Rit tuning
-        if (knob < 0) ubitx::frequency -= 100l;
-        else if (knob > 0) ubitx::frequency += 100;
+        knob = encoder::Read(encoder::RIT);
+        ubitx::frequency += knob * 10l;
       } else {
         // Normal tuning
-        if (abs(knob) > 6) ubitx::frequency += knob * 1000;
-        else ubitx::frequency += knob * 50;
+        knob = encoder::Read(encoder::TUNING);
+        ubitx::frequency += knob * 50l;
       }
+      if (ubitx::in_tx) swr::Draw();  // cw or cat transmit
+      if (knob == 0) break;
+      perf::End(perf::KNOB);
 
       ubitx::SetFrequency(ubitx::frequency);
-      ui::UpdateDisplay();
+      perf::EndOnBus(perf::RF);
       break;
   }
 }
@@ -175,8 +203,31 @@ void DoTuning() {
 //
 
 void Run() {
-  CheckButtons(); // update buttons - debounces, clicks
-  DoActiveApp(); // DoTuning, DoMenu or DoTx
+  unsigned int prof = perf::Enter();
+  void (*app)() = DoActiveApp;
+  app(); // DoTuning, DoMenu or DoTx
+  perf::Leave(app == DoTuning ? perf::P_TUNING
+              : app == DoTx ? perf::P_TX : perf::P_MENU, prof);
+  ubitx::DispatchChanges();
+}
+
+void UpdateVoltage() {
+  if (DoActiveApp != DoTuning) return;
+  unsigned int prof = perf::Enter();
+  ui::UpdateVoltage();
+  perf::Leave(perf::P_DRAW, prof);
+}
+
+void CatTask() {
+  unsigned int prof = perf::Enter();
+  cat::Run();
+  perf::Leave(perf::P_CAT, prof);
+}
+
+void KeyerTask() {
+  unsigned int prof = perf::Enter();
+  keyer::Run();
+  perf::Leave(perf::P_KEYER, prof);
 }
 
 }  // namespace
@@ -185,37 +236,45 @@ void Run() {
 // Arduino setup function
 
 void setup() {
+  i2c::Init();
+  perf::Init();
   Serial.begin(38400);
   Serial.flush();  
 
   ubitx::InitPorts();     
   
-  ui::u8x8.begin();
-  // the "_f" version uses extra 1280 bytes of storage space
-  // u8x8.setFont(u8x8_font_amstrad_cpc_extended_f); 
-  ui::u8x8.setFont(U8X8_MAINFONT); 
+  ui::Init();
 
   //we print this line so this shows up even if the raduino 
   //crashes later in the code
-  ui::u8x8.draw1x2String(1, 1, "YL3AME"); 
+  ui::Draw1x2String_P(1, 1, PSTR("YL3AME")); 
+  ui::Flush();
+  watchdog::Report();
 
   ubitx::InitSettings();
   if (mainloop::FBtnDown())
     ubitx::ResetSettingsAndHalt();
 
   encoder::Init();
+  mainloop::InitButtons();
   ubitx::InitOscillators();
 
   ubitx::SetFrequency(ubitx::settings.vfo_a);
   ubitx::SidebandSet(ubitx::settings.vfo_a_usb);
 
   mainloop::DoActiveApp = mainloop::DoTuning;
+
+  //          name    task                      period ms    prio budget us
+  sched::Add(PSTR("KEY"),  mainloop::KeyerTask,       1,           0,   200);
+  sched::Add(PSTR("CAT"),  mainloop::CatTask,         0,           1,   2000, cat::Ready);
+  sched::Add(PSTR("APP"),  mainloop::Run,             2,           2,   2000);
+  sched::Add(PSTR("DISP"), ui::Run,                   ui::FLUSH_MS, 3,  2000);
+  sched::Add(PSTR("VOLT"), mainloop::UpdateVoltage,   500,         4,   2000);
+  watchdog::Init();
 }
 
 // Arduino loop function
 
 void loop() { 
-  cat::Run();
-  keyer::Run();
-  mainloop::Run();
+  sched::Run();
 }
@@ -3,13 +3,16 @@
 
 namespace mainloop {
 
-const int debounce_count = 500; // TODO reduce, research
-
+// Debounced by the Timer0 compare interrupt. The states follow the
+// buttons, the events are set there and cleared by whoever handles them.
 extern struct Buttons {
-  bool f_down = false; // 
-  bool ptt_down = false; //
-  bool f_clicked = false; //
-  bool f_held = false;
+  volatile bool f_down = false;
+  volatile bool ptt_down = false;
+  volatile bool f_pressed = false;
+  volatile bool f_released = false;
+  volatile bool f_clicked = false;
+  volatile bool f_held = false;
+  volatile bool f_double_clicked = false;
 } buttons;
 
 extern void (*DoActiveApp)();
@@ -4,30 +4,51 @@
 #include "hw.h"
 #include "mainloop.h"
 #include "keyer.h"
+#include "perf.h"
+#include "power.h"
+#include "sched.h"
+#include "scope.h"
 #include "si5351.h"
+#include "swr.h"
 #include "ubitx.h"
 #include "ui.h"
 
 namespace menu {
 
-char b[12]; // holds strings up to ltoa "-2147483647\0"
-            // also itoa with prefix    "-32767 HZ..\0"
+char b[16]; // holds strings up to ltoa "-2147483647\0"
+            // also a whole value column "VOLTAGE 1023\0"
+
+/**
+ * Every entry of the menu is a descriptor in flash. The list shows the
+ * label with what Format() writes right aligned. A click on an item with
+ * a step opens the knob screen from Get() over min .. max, Preview()
+ * draws value.current while it turns and a second click hands it to
+ * Set(). A click on an item without a step just calls Set(0), an action.
+ * Adding a setting is one row in ITEMS.
+ */
+struct Item {
+  PGM_P label;              // 0 for items whose Format() says it all
+  void (*Format)(char *s);  // 0 for none
+  int (*Get)();
+  void (*Set)(int v);
+  void (*Preview)();
+  PGM_P units;              // on the knob screen
+  int min;
+  int max;
+  int step;                 // 0 for an action
+  unsigned char flags;
+};
+
+const unsigned char ADVANCED = 0x01;  // only in the advanced menu
+const unsigned char STAY = 0x02;      // the menu stays up after the action
+const unsigned char LIVE = 0x04;      // Format() is redrawn while shown
+const unsigned char APP = 0x08;       // the action starts another app
 
 enum DO_MENU_STATES {
   STATE_INITIAL,
-  STATE_DRAW_SELECTED,
   STATE_SELECTING_MENU,
-  STATE_MENU_ITEM_ACTIVE,
-  STATE_OPEN_ADVANCED,
-  STATE_EXIT,
   STATE_WAIT_VALUE,
-  STATE_VALUE_RETURNED
-};
-
-enum MENU_HANDLER_STATES {
-  EVENT_SELECTED,
-  EVENT_ACTIVE,
-  EVENT_VALUE,
+  STATE_EXIT
 };
 
 // Is the advanced menu visible?
@@ -47,16 +68,16 @@ void SetWaitValues(int min, int max, int step, int current, void (*PreviewCallba
   value.step = step;
   value.current = current;
   value.PreviewCallback = PreviewCallback;
-  value.PreviewCallback();
+  if (value.PreviewCallback) value.PreviewCallback();
 }
 
 unsigned char wait_knob_right = 0;
 
-void DrawWaitKnobScreen(const char* title, const char *units) {
-  ui::u8x8.clear();
-  ui::u8x8.draw1x2String(1, 6, title);
-  wait_knob_right = 16 - strlen(units);
-  ui::u8x8.draw1x2String(wait_knob_right, 4, units);
+void DrawWaitKnobScreen(PGM_P title, PGM_P units) {
+  ui::Clear();
+  ui::Draw1x2String_P(1, 6, title);
+  wait_knob_right = 16 - strlen_P(units);
+  ui::Draw1x2String_P(wait_knob_right, 4, units);
   wait_knob_right--;
 }
 
@@ -64,169 +85,177 @@ void PreviewCurrentValue() {
   ltoa(value.current, b, 10);
   int8_t i = wait_knob_right - strlen(b) * 2;
 
-  ui::u8x8.setFont(U8X8_DIGITFONT);
-  ui::u8x8.drawString(i, 3, b);
-  ui::u8x8.setFont(U8X8_MAINFONT);
+  ui::DrawDigits(i, 3, b);
   while (i-- > 1) {
-    ui::u8x8.draw1x2Glyph(i, 3, ' ');
-    ui::u8x8.drawGlyph(i, 5, ' ');
+    ui::Draw1x2Glyph(i, 3, ' ');
+    ui::ClearTile(i, 5);
   }
 }
 
-static const char* STR_ON = "ON";
-static const char* STR_OFF = "OFF";
-static const char* STR_WPM = "WPM";
-static const char* STR_BAND = "BAND";
-static const char* STR_CW_DELAY = "CW DELAY";
-static const char* STR_CW_TONE = "CW TONE";
-static const char* STR_CW_KEY = "CW KEY";
-static const char* STRS_IAMBIC[3] = {"STRIGHT", "IAMBIC-A", "IAMBIC-B"};
-static const char* STRS_ADC[4] = {"FBUTTON", "PTT", "KEYER", "VOLTAGE"};
-static const int   PINS_ADC[4] = { hw::FBUTTON, hw::PTT, hw::ANALOG_KEYER, hw::ANALOG_V};
+// Strings and tables live in flash, see the _P functions in ui
+const char STR_ON[] PROGMEM = "ON";
+const char STR_OFF[] PROGMEM = "OFF";
+const char STR_STRAIGHT[] PROGMEM = "STRIGHT";
+const char STR_IAMBIC_A[] PROGMEM = "IAMBIC-A";
+const char STR_IAMBIC_B[] PROGMEM = "IAMBIC-B";
+const char *const STRS_IAMBIC[3] PROGMEM = {STR_STRAIGHT, STR_IAMBIC_A, STR_IAMBIC_B};
+const char STR_FBUTTON[] PROGMEM = "FBUTTON";
+const char STR_PTT[] PROGMEM = "PTT";
+const char STR_KEYER[] PROGMEM = "KEYER";
+const char STR_VOLTAGE[] PROGMEM = "VOLTAGE";
+const char *const STRS_ADC[4] PROGMEM = {STR_FBUTTON, STR_PTT, STR_KEYER, STR_VOLTAGE};
+const unsigned char PINS_ADC[4] PROGMEM = {hw::FBUTTON, hw::PTT, hw::ANALOG_KEYER, hw::ANALOG_V};
+
+// Entry i of a PROGMEM table of flash strings
+PGM_P StringAt(const char *const *table, unsigned char i) {
+  return (PGM_P)pgm_read_ptr(table + i);
+}
 
-void PreviewBand() {
-  ubitx::SetFrequency((ubitx::frequency % 100000l) + (value.current * 100000l));
-  ui::u8x8.draw1x2String(12,1,ubitx::BAND_LIST[ubitx::active_band].name);
-  ui::PrintFrequency();
-}
-
-unsigned char MenuBand(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLineValue(6, STR_BAND,
-                         ubitx::BAND_LIST[ubitx::active_band].name);
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      ui::u8x8.clear();
-      ui::PrintLine(6, STR_BAND);
-      ubitx::RitDisable();
-
-      SetWaitValues(ubitx::LOWEST_FREQ / 100000l,
-                    ubitx::HIGHEST_FREQ / 100000l,
-                    1,
-                    ubitx::frequency / 100000l,
-                    PreviewBand);
-      return STATE_WAIT_VALUE;
-    case EVENT_VALUE:
-      return STATE_EXIT;
-  }
-  return false;
-}
-
-unsigned char MenuRitToggle(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLineValue(6, "RIT", ubitx::status.shift_mode == ubitx::SHIFT_RIT ? STR_ON : STR_OFF);
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      if (ubitx::status.shift_mode == ubitx::SHIFT_RIT)
-        ubitx::RitDisable();
-      else
-        ubitx::RitEnable(ubitx::frequency);
-      return STATE_EXIT;
-  }
-  return STATE_EXIT;
+void FormatOnOff(char *s, bool on) {
+  strcpy_P(s, on ? STR_ON : STR_OFF);
 }
 
-unsigned char MenuVfoToggle(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLineValue(6, "VFO", ubitx::status.vfo_a_active ? "A" : "B");
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      ubitx::VfoSwap(/* save=*/true);
-      return STATE_EXIT;
-  }
-  return STATE_EXIT;
+// A number and its units, "20 WPM"
+void FormatUnits(char *s, int v, PGM_P units) {
+  itoa(v, s, 10);
+  strcat_P(s, PSTR(" "));
+  strcat_P(s, units);
 }
 
-unsigned char MenuVfoCopy(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLineValue(6, "VFO", "A=B");
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      ubitx::VfoCopy(/* save=*/true);
-      return STATE_EXIT;
-  }
-  return STATE_EXIT;
+// Tenths as "3.0"
+void FormatTenths(char *s, int tenths) {
+  s[0] = '0' + tenths / 10;
+  s[1] = '.';
+  s[2] = '0' + tenths % 10;
+  s[3] = 0;
 }
 
-unsigned char MenuSidebandToggle(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLineValue(6, "MODE", ubitx::status.is_usb ? "USB" : "LSB");
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      ubitx::SidebandSet(!ubitx::status.is_usb);
-      return STATE_EXIT;
+// "avg/max" in us, or both in MS from 10 ms up so it stays within the
+// line. The font has no lowercase.
+void FormatTimes(char *s, unsigned long avg_us, unsigned long max_us) {
+  bool ms = max_us >= 10000;
+  if (ms) {
+    avg_us /= 1000;
+    max_us /= 1000;
   }
-  return STATE_EXIT;
+  ultoa(avg_us, s, 10);
+  strcat_P(s, PSTR("/"));
+  ultoa(max_us, s + strlen(s), 10);
+  if (ms) strcat_P(s, PSTR("MS"));
 }
 
-unsigned char MenuSplitToggle(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLineValue(6, "SPLIT", ubitx::status.shift_mode == ubitx::SHIFT_SPLIT ? STR_ON : STR_OFF);
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      if (ubitx::status.shift_mode == ubitx::SHIFT_SPLIT)
-        ubitx::SplitDisable();
-      else
-        ubitx::SplitEnable();
-      return STATE_EXIT;
-  }
-  return STATE_EXIT;
+// Items that open something else
+void FormatOpen(char *s) {
+  strcpy_P(s, PSTR(">"));
 }
 
-unsigned char MenuCwSpeed(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      itoa(1200 / ubitx::settings.cw_speed, b, 10);
-      strcat(b, " ");
-      strcat(b, STR_WPM);
-      ui::PrintLineValue(6, "CW", b);
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      DrawWaitKnobScreen("CW SPEED", STR_WPM);
-      SetWaitValues(1, 100, 1, 1200 / ubitx::settings.cw_speed,
-                    PreviewCurrentValue);
-      return STATE_WAIT_VALUE;
-    case EVENT_VALUE:
-      ubitx::CwSpeedSet(1200 / value.current);
-      return STATE_EXIT;
-  }
-  return STATE_EXIT;
+// VFO
+
+void FormatVfo(char *s) {
+  s[0] = ubitx::status.vfo_a_active ? 'A' : 'B';
+  s[1] = 0;
 }
 
-unsigned char MenuExit(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLine(6, "EXIT MENU");
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      return STATE_EXIT;
-  }
-  return STATE_EXIT;
+void SetVfoSwap(int) {
+  ubitx::VfoSwap(/* save=*/true);
+}
+
+void SetVfoCopy(int) {
+  ubitx::VfoCopy(/* save=*/true);
+}
+
+// CW SPEED, kept as the dot length in ms
+
+void FormatCwSpeed(char *s) {
+  FormatUnits(s, 1200 / ubitx::settings.cw_speed, PSTR("WPM"));
+}
+
+int GetCwSpeed() {
+  return 1200 / ubitx::settings.cw_speed;
+}
+
+void SetCwSpeed(int wpm) {
+  ubitx::CwSpeedSet(1200 / wpm);
+}
+
+// RIT, MODE, SPLIT
+
+void FormatRit(char *s) {
+  FormatOnOff(s, ubitx::status.shift_mode == ubitx::SHIFT_RIT);
+}
+
+void SetRit(int) {
+  if (ubitx::status.shift_mode == ubitx::SHIFT_RIT)
+    ubitx::RitDisable();
+  else
+    ubitx::RitEnable(ubitx::frequency);
+}
+
+void FormatMode(char *s) {
+  strcpy_P(s, ubitx::status.is_usb ? PSTR("USB") : PSTR("LSB"));
+}
+
+void SetMode(int) {
+  ubitx::SidebandSet(!ubitx::status.is_usb);
+}
+
+void FormatSplit(char *s) {
+  FormatOnOff(s, ubitx::status.shift_mode == ubitx::SHIFT_SPLIT);
+}
+
+void SetSplit(int) {
+  if (ubitx::status.shift_mode == ubitx::SHIFT_SPLIT)
+    ubitx::SplitDisable();
+  else
+    ubitx::SplitEnable();
+}
+
+// BAND, the knob moves the dial in 100 kHz steps and retunes right away
+
+void FormatBand(char *s) {
+  strcpy_P(s, ubitx::BAND_LIST[ubitx::active_band].name);
+}
+
+int GetBand() {
+  ubitx::RitDisable();
+  return ubitx::frequency / 100000l;
+}
+
+void PreviewBand() {
+  ubitx::SetFrequency((ubitx::frequency % 100000l) + (value.current * 100000l));
+  ui::Draw1x2String_P(12, 1, ubitx::BAND_LIST[ubitx::active_band].name);
+  ui::RequestFrequency();
+}
+
+void SetBand(int) {
+}
+
+// SCOPE hands the screen and the knob to the band scope until it is
+// clicked away
+
+void SetScope(int) {
+  mainloop::DoActiveApp = scope::DoScope;
 }
 
 /**
  * The calibration routines are not normally shown in the menu as they are
  * rarely used. They can be enabled by choosing this menu option.
  */
-unsigned char MenuAdvanced(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLineValue(6, "ADVANCED", advanced_menu ? STR_ON : ">");
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      if (!advanced_menu) {
-        return STATE_OPEN_ADVANCED;
-      }
-      advanced_menu = false;
-      return STATE_EXIT;
-  }
-  return STATE_EXIT;
+void FormatAdvanced(char *s) {
+  if (advanced_menu)
+    strcpy_P(s, STR_ON);
+  else
+    FormatOpen(s);
+}
+
+void SetAdvanced(int) {
+  advanced_menu = !advanced_menu;
+}
+
+// CALIBRATE, in steps of 875 Hz of the VCO
+
+int GetCalibration() {
+  return ubitx::settings.master_cal / 875;
 }
 
 void PreviewCalibration() {
@@ -234,29 +263,21 @@ void PreviewCalibration() {
   si5351::SetFreq(0, ubitx::settings.usb_carrier);
   ubitx::SetFrequency(ubitx::frequency);
 
+  ui::PrintLine_P(0, PSTR("ZERO BEAT TO"));
+  ultoa(ubitx::frequency, b, DEC);
+  ui::PrintLine(2, b);
   ltoa((long)value.current * 875, b, DEC);
-  ui::PrintLine(5, b);
-}
-
-unsigned char MenuSetupCalibration(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLine(6, "CALIBRATE");
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      ui::u8x8.clear();
-      ui::u8x8.draw1x2String(1, 1, "ZERO BEAT TO");
-      ultoa(ubitx::frequency, b, DEC);
-      ui::u8x8.draw1x2String(1, 3, b);
-
-      SetWaitValues(-10000, 10000, 1, ubitx::settings.master_cal / 875,
-                    PreviewCalibration);
-      return STATE_WAIT_VALUE;
-    case EVENT_VALUE:
-      ubitx::SetMasterCal((long)value.current * 875);
-      return STATE_EXIT;
-  }
-  return STATE_EXIT;
+  ui::PrintLine(4, b);
+}
+
+void SetCalibration(int v) {
+  ubitx::SetMasterCal((long)v * 875);
+}
+
+// CAL BFO, values from 11021000 to 11085000
+
+int GetCarrier() {
+  return ubitx::settings.usb_carrier - 11053000;
 }
 
 void PreviewCarrier() {
@@ -265,23 +286,18 @@ void PreviewCarrier() {
   ui::PrintLine(4, b);
 }
 
-unsigned char MenuSetupCarrier(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLine(6, "CAL BFO");
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      DrawWaitKnobScreen("CALIBRATE BFO", "");
-      //
-      // Values from 11000000 to 11099999
-      SetWaitValues(-32000, 32000, 10, ubitx::settings.usb_carrier - 11053000,
-                    PreviewCarrier);
-      return STATE_WAIT_VALUE;
-    case EVENT_VALUE:
-      ubitx::SetUsbCarrier(value.current + 11053000);
-      return STATE_EXIT;
-  }
-  return STATE_EXIT;
+void SetCarrier(int v) {
+  ubitx::SetUsbCarrier(v + 11053000);
+}
+
+// CW TONE, heard while it turns
+
+void FormatCwTone(char *s) {
+  FormatUnits(s, ubitx::settings.cw_side_tone, PSTR("HZ"));
+}
+
+int GetCwTone() {
+  return ubitx::settings.cw_side_tone;
 }
 
 void PreviewSidetone() {
@@ -289,228 +305,403 @@ void PreviewSidetone() {
   PreviewCurrentValue();
 }
 
-unsigned char MenuSetupCwTone(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      itoa(ubitx::settings.cw_side_tone, b, 10);
-      strcat(b, " HZ");
-      ui::PrintLineValue(6, STR_CW_TONE, b);
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      DrawWaitKnobScreen(STR_CW_TONE, "HZ");
-      SetWaitValues(100, 2000, 10, ubitx::settings.cw_side_tone,
-                    PreviewSidetone);
-      return STATE_WAIT_VALUE;
-    case EVENT_VALUE:
-      noTone(hw::CW_TONE);
-      ubitx::CwToneSet(value.current);
-      return STATE_EXIT;
+void SetCwTone(int v) {
+  noTone(hw::CW_TONE);
+  ubitx::CwToneSet(v);
+}
+
+// CW DELAY
+
+void FormatCwDelay(char *s) {
+  FormatUnits(s, ubitx::settings.cw_delay_time, PSTR("MS"));
+}
+
+int GetCwDelay() {
+  return ubitx::settings.cw_delay_time;
+}
+
+void SetCwDelay(int v) {
+  ubitx::CwDelayTimeSet(v);
+}
+
+// CW KEY
+
+void FormatKeyer(char *s) {
+  strcpy_P(s, StringAt(STRS_IAMBIC, ubitx::settings.iambic_key));
+}
+
+int GetKeyer() {
+  return ubitx::settings.iambic_key;
+}
+
+void PreviewKeyer() {
+  PGM_P name = StringAt(STRS_IAMBIC, value.current);
+  ui::Draw1x2String_P(4, 3, name);
+  for (unsigned char i = strlen_P(name) + 4; i <= 15; i++) {
+    ui::Draw1x2Glyph(i, 3, ' ');
   }
-  return STATE_EXIT;
 }
 
-unsigned char MenuSetupCwDelay(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      itoa(ubitx::settings.cw_delay_time, b, 10);
-      strcat(b, " MS");
-      ui::PrintLineValue(6, STR_CW_DELAY, b);
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      DrawWaitKnobScreen(STR_CW_DELAY, "MS");
-      SetWaitValues(10, 1010, 50, ubitx::settings.cw_delay_time,
-                    PreviewCurrentValue);
-      return STATE_WAIT_VALUE;
-    case EVENT_VALUE:
-      ubitx::CwDelayTimeSet(value.current);
-      return STATE_EXIT;
+void SetKeyer(int v) {
+  ubitx::IambicKeySet(v);
+}
+
+// TX CW TEST, four dashes
+
+void SetTxTest(int) {
+  ubitx::TxStartCw();
+  for (int i=1; i<5; i++) {
+    keyer::CwKeydown();
+    ubitx::ActiveDelay(200);
+    keyer::CwKeyUp();
+    ubitx::ActiveDelay(500);
   }
-  return STATE_EXIT;
+  ubitx::TxStop();
 }
 
-void PreviewKeyer() {
-  ui::u8x8.draw1x2String(4, 3, STRS_IAMBIC[value.current]);
-  for (unsigned char i = strlen(STRS_IAMBIC[value.current]) + 4; i <= 15; i++) {
-    ui::u8x8.draw1x2Glyph(i, 3, ' ');
+// ADC, the raw reading of one input, a click moves on to the next
+
+unsigned char adc_selected = 0;
+
+void FormatAdc(char *s) {
+  strcpy_P(s, StringAt(STRS_ADC, adc_selected));
+  strcat_P(s, PSTR(" "));
+  if (swr::Sampling())  // the ADC is taken
+    strcat_P(s, PSTR("--"));
+  else
+    itoa(analogRead(pgm_read_byte(PINS_ADC + adc_selected)), s + strlen(s), 10);
+}
+
+void SetAdc(int) {
+  adc_selected = (adc_selected + 1) % 4;
+}
+
+// SWR LIMIT, the point between the digit pairs on their baseline
+
+void FormatSwrLimit(char *s) {
+  FormatTenths(s, ubitx::settings.swr_limit);
+}
+
+int GetSwrLimit() {
+  return ubitx::settings.swr_limit;
+}
+
+void PreviewSwrLimit() {
+  unsigned char x = wait_knob_right - 5;
+  ui::DrawDigit(x, 3, '0' + value.current / 10);
+  ui::Draw1x2Glyph(x + 2, 4, '.');
+  ui::DrawDigit(x + 3, 3, '0' + value.current % 10);
+}
+
+void SetSwrLimit(int v) {
+  ubitx::SwrLimitSet(v);
+}
+
+// TASKS, one scheduler task at a time: overruns and late starts (shown
+// up to 99) and the longest run. A click writes all counters of all
+// tasks to serial and moves on to the next task.
+
+unsigned char task_shown = 0;
+
+void FormatCount(char *s, unsigned int n) {
+  utoa(n > 99 ? 99 : n, s + strlen(s), 10);
+  strcat_P(s, PSTR(" "));
+}
+
+void FormatTask(char *s) {
+  if (task_shown >= sched::task_count) task_shown = 0;
+  const sched::Task *t = &sched::tasks[task_shown];
+  strcpy_P(s, t->name);
+  strcat_P(s, PSTR(" "));
+  FormatCount(s, t->overruns);
+  FormatCount(s, t->late);
+  if (t->max_us < 10000) {
+    utoa(t->max_us, s + strlen(s), 10);
+  } else {
+    utoa(t->max_us / 1000, s + strlen(s), 10);
+    strcat_P(s, PSTR("MS"));
   }
 }
 
-unsigned char MenuSetupKeyer(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLineValue(6, STR_CW_KEY, STRS_IAMBIC[ubitx::settings.iambic_key]);
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      DrawWaitKnobScreen(STR_CW_KEY, "");
-      SetWaitValues(0, 2, 1, ubitx::settings.iambic_key, PreviewKeyer);
-      return STATE_WAIT_VALUE;
-    case EVENT_VALUE:
-      ubitx::IambicKeySet(value.current);
-      return STATE_EXIT;
+void SetTask(int) {
+  sched::Dump();
+  task_shown++;
+}
+
+// CPU BUSY, the share of the last second the scheduler did not sleep,
+// in every build
+
+void FormatBusy(char *s) {
+  itoa(power::BusyPercent(), s, DEC);
+  strcat_P(s, PSTR("%"));
+}
+
+// RESET
+
+void SetReset(int) {
+  ubitx::ResetSettingsAndHalt();
+}
+
+#if PERF_ENABLED || PERF_PROFILE
+// Hidden entry after EXIT, only built with PERF_ENABLED or PERF_PROFILE.
+// Shows avg/max us of one profiled section or latency series, a click
+// dumps them all to serial and moves on to the next.
+const unsigned char PERF_FIRST = perf::PROFILE ? 0 : perf::SECTIONS;
+const unsigned char PERF_END = perf::SECTIONS + (perf::ENABLED ? perf::SERIES : 0);
+unsigned char perf_shown = PERF_FIRST;
+
+void FormatPerf(char *s) {
+  PGM_P name;
+  unsigned long avg;
+  unsigned int max;
+#if PERF_PROFILE
+  if (perf_shown < perf::SECTIONS) {
+    perf::Profile p;
+    perf::GetProfile(perf_shown, &p);
+    name = StringAt(perf::SECTION_NAMES, perf_shown);
+    avg = p.count ? p.total / p.count : 0;
+    max = p.max;
   }
-  return STATE_EXIT;
+#endif
+#if PERF_ENABLED
+  if (perf_shown >= perf::SECTIONS) {
+    perf::Stats st;
+    perf::Get(perf_shown - perf::SECTIONS, &st);
+    name = StringAt(perf::NAMES, perf_shown - perf::SECTIONS);
+    avg = st.count ? st.sum / st.count : 0;
+    max = st.max;
+  }
+#endif
+  strcpy_P(s, name);
+  strcat_P(s, PSTR(" "));
+  FormatTimes(s + strlen(s), avg * 4, max * 4ul);
 }
 
-unsigned char MenuTxToggle(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      //ui::PrintLineValue(6, "TX INHIBIT", ubitx::status.tx_inhibit ? STR_ON : STR_OFF);
-      ui::PrintLine(6, "TX CW TEST");
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      //ubitx::status.tx_inhibit = !ubitx::status.tx_inhibit;
-      ubitx::TxStartCw();
-      for (int i=1; i<5; i++) {
-        keyer::CwKeydown();
-        delay(200);
-        keyer::CwKeyUp();
-        delay(500);
-      }
-      ubitx::TxStop();
-      return STATE_EXIT;
+void SetPerf(int) {
+  perf::Dump();
+  ui::Benchmark();
+  if (++perf_shown == PERF_END) perf_shown = PERF_FIRST;
+}
+#endif
+
+const char STR_VFO[] PROGMEM = "VFO";
+const char STR_VFO_COPY[] PROGMEM = "VFO A=B";
+const char STR_CW_SPEED[] PROGMEM = "CW SPEED";
+const char STR_WPM[] PROGMEM = "WPM";
+const char STR_RIT[] PROGMEM = "RIT";
+const char STR_BAND[] PROGMEM = "BAND";
+const char STR_MODE[] PROGMEM = "MODE";
+const char STR_SCOPE[] PROGMEM = "SCOPE";
+const char STR_ADVANCED[] PROGMEM = "ADVANCED";
+const char STR_CALIBRATE[] PROGMEM = "CALIBRATE";
+const char STR_CAL_BFO[] PROGMEM = "CAL BFO";
+const char STR_CW_TONE[] PROGMEM = "CW TONE";
+const char STR_HZ[] PROGMEM = "HZ";
+const char STR_CW_DELAY[] PROGMEM = "CW DELAY";
+const char STR_MS[] PROGMEM = "MS";
+const char STR_CW_KEY[] PROGMEM = "CW KEY";
+const char STR_SPLIT[] PROGMEM = "SPLIT";
+const char STR_TX_TEST[] PROGMEM = "TX CW TEST";
+const char STR_SWR_LIMIT[] PROGMEM = "SWR LIMIT";
+const char STR_SWR_UNITS[] PROGMEM = ":1";
+const char STR_BUSY[] PROGMEM = "CPU BUSY";
+const char STR_RESET[] PROGMEM = "RESET";
+const char STR_EXIT[] PROGMEM = "EXIT MENU";
+const char STR_NONE[] PROGMEM = "";
+
+const Item ITEM_LIST[] PROGMEM = {
+  // label          Format          Get             Set            Preview              units          min     max  step flags
+  {STR_VFO,         FormatVfo,      0,              SetVfoSwap,    0,                   0,               0,      0,  0, 0},
+  {STR_VFO_COPY,    0,              0,              SetVfoCopy,    0,                   0,               0,      0,  0, 0},
+  {STR_CW_SPEED,    FormatCwSpeed,  GetCwSpeed,     SetCwSpeed,    PreviewCurrentValue, STR_WPM,         1,    100,  1, 0},
+  {STR_RIT,         FormatRit,      0,              SetRit,        0,                   0,               0,      0,  0, 0},
+  {STR_BAND,        FormatBand,     GetBand,        SetBand,       PreviewBand,         STR_NONE,
+                    ubitx::LOWEST_FREQ / 100000l,   ubitx::HIGHEST_FREQ / 100000l,            1, 0},
+  {STR_MODE,        FormatMode,     0,              SetMode,       0,                   0,               0,      0,  0, 0},
+  {STR_SCOPE,       FormatOpen,     0,              SetScope,      0,                   0,               0,      0,  0, APP},
+  {STR_ADVANCED,    FormatAdvanced, 0,              SetAdvanced,   0,                   0,               0,      0,  0, STAY},
+  {STR_CALIBRATE,   0,              GetCalibration, SetCalibration, PreviewCalibration, STR_NONE,   -10000,  10000,  1, ADVANCED},
+  {STR_CAL_BFO,     0,              GetCarrier,     SetCarrier,    PreviewCarrier,      STR_NONE,   -32000,  32000, 10, ADVANCED},
+  {STR_CW_TONE,     FormatCwTone,   GetCwTone,      SetCwTone,     PreviewSidetone,     STR_HZ,        100,   2000, 10, ADVANCED},
+  {STR_CW_DELAY,    FormatCwDelay,  GetCwDelay,     SetCwDelay,    PreviewCurrentValue, STR_MS,         10,   1010, 50, ADVANCED},
+  {STR_CW_KEY,      FormatKeyer,    GetKeyer,       SetKeyer,      PreviewKeyer,        STR_NONE,        0,      2,  1, ADVANCED},
+  {STR_SPLIT,       FormatSplit,    0,              SetSplit,      0,                   0,               0,      0,  0, ADVANCED},
+  {STR_TX_TEST,     0,              0,              SetTxTest,     0,                   0,               0,      0,  0, ADVANCED},
+  {0,               FormatAdc,      0,              SetAdc,        0,                   0,               0,      0,  0, ADVANCED | STAY | LIVE},
+  {STR_SWR_LIMIT,   FormatSwrLimit, GetSwrLimit,    SetSwrLimit,   PreviewSwrLimit,     STR_SWR_UNITS,
+                    swr::LIMIT_MIN, swr::LIMIT_MAX,                                                    1, ADVANCED},
+  {0,               FormatTask,     0,              SetTask,       0,                   0,               0,      0,  0, ADVANCED | STAY | LIVE},
+  {STR_BUSY,        FormatBusy,     0,              0,             0,                   0,               0,      0,  0, ADVANCED | STAY | LIVE},
+  {STR_RESET,       0,              0,              SetReset,      0,                   0,               0,      0,  0, ADVANCED},
+  {STR_EXIT,        0,              0,              0,             0,                   0,               0,      0,  0, 0},
+#if PERF_ENABLED || PERF_PROFILE
+  {0,               FormatPerf,     0,              SetPerf,       0,                   0,               0,      0,  0, ADVANCED | STAY | LIVE},
+#endif
+};
+const unsigned char ITEMS = sizeof(ITEM_LIST) / sizeof(ITEM_LIST[0]);
+
+void LoadItem(unsigned char i, Item *item) {
+  memcpy_P(item, ITEM_LIST + i, sizeof(Item));
+}
+
+bool Visible(unsigned char i) {
+  unsigned char flags = pgm_read_byte(&ITEM_LIST[i].flags);
+  if ((flags & ADVANCED) && !advanced_menu) return false;
+  return true;
+}
+
+/**
+ * The list, LINES items of two rows each with the selected one marked by
+ * the cursor in column 0. A line is only drawn again when another item
+ * moved onto it or its value may have changed, and the tile shadow then
+ * sends only the tiles that differ.
+ */
+const unsigned char LINES = ui::ROWS / 2;
+const unsigned char NONE = 0xff;
+const unsigned int LIVE_MS = 250;
+
+unsigned char selected;         // item
+unsigned char top;              // item on the first line
+unsigned char shown[LINES];     // item drawn on each line, NONE for empty
+unsigned long next_live = 0;
+
+unsigned char Next(unsigned char i) {
+  while (++i < ITEMS) {
+    if (Visible(i)) return i;
   }
-  return STATE_EXIT;
+  return NONE;
 }
 
-unsigned char MenuReadADC1(unsigned char event) {
-  static unsigned char selected = 0;
-  static int last_adc;
+unsigned char Prev(unsigned char i) {
+  while (i-- > 0) {
+    if (Visible(i)) return i;
+  }
+  return NONE;
+}
 
-  switch (event) {
-    case EVENT_SELECTED: {
-      int adc = analogRead(PINS_ADC[selected]);
-      if (adc != last_adc) {
-        last_adc = adc;
-        itoa(adc, b, 10);
-        ui::PrintLineValue(6, STRS_ADC[selected], b);
-      }
-      return STATE_DRAW_SELECTED;
-    }
-    case EVENT_ACTIVE:
-      selected = (selected + 1) % 4;
-      return STATE_DRAW_SELECTED;
+void DrawItem(unsigned char line, unsigned char i) {
+  if (i == NONE) {
+    ui::PrintLine(line * 2, "");
+    return;
   }
-  return STATE_EXIT;
+  Item item;
+  LoadItem(i, &item);
+  b[0] = 0;
+  if (item.Format) item.Format(b);
+  ui::PrintLineValue_P(line * 2, item.label ? item.label : STR_NONE, b);
 }
 
-unsigned char MenuResetSettings(unsigned char event) {
-  switch (event) {
-    case EVENT_SELECTED:
-      ui::PrintLine(6, "RESET");
-      return STATE_SELECTING_MENU;
-    case EVENT_ACTIVE:
-      ubitx::ResetSettingsAndHalt();
+// all redraws every line, after something that changes values or which
+// items are visible
+void DrawList(bool all) {
+  bool live = (long)(millis() - next_live) >= 0;
+  if (live || all) next_live = millis() + LIVE_MS;
+  unsigned char i = top;
+  for (unsigned char line = 0; line < LINES; line++) {
+    bool draw = all || i != shown[line];
+    if (!draw && live && i != NONE) draw = pgm_read_byte(&ITEM_LIST[i].flags) & LIVE;
+    if (draw) DrawItem(line, i);
+    shown[line] = i;
+    ui::Draw1x2Glyph(0, line * 2, i == selected && i != NONE ? '>' : ' ');
+    if (i != NONE) i = Next(i);
   }
-  // the above EVENT_ACTIVE case halts, so technically this is unreachable:
-  return STATE_EXIT;
 }
 
-unsigned char CallMenuHandler(unsigned char menu, unsigned char event) {
-  switch (menu) {
-    case  0: return MenuVfoToggle(event);
-    case  1: return MenuVfoCopy(event);
-    case  2: return MenuCwSpeed(event);
-    case  3: return MenuRitToggle(event);
-    case  4: return MenuBand(event);
-    case  5: return MenuSidebandToggle(event);
-    case  6: return MenuAdvanced(event);
-    case  7: return MenuSetupCalibration(event);
-    case  8: return MenuSetupCarrier(event);
-    case  9: return MenuSetupCwTone(event);
-    case 10: return MenuSetupCwDelay(event);
-    case 11: return MenuSetupKeyer(event);
-    case 12: return MenuSplitToggle(event);
-    case 13: return MenuTxToggle(event);
-    case 14: return MenuReadADC1(event);
-    case 15: return MenuResetSettings(event);
-    case 16: return MenuExit(event);
+// Moves the selection by steps visible items and scrolls it into view
+void Select(int steps) {
+  for (; steps > 0; steps--) {
+    unsigned char i = Next(selected);
+    if (i == NONE) break;
+    selected = i;
+  }
+  for (; steps < 0; steps++) {
+    unsigned char i = Prev(selected);
+    if (i == NONE) break;
+    selected = i;
+  }
+  if (selected < top) top = selected;
+  unsigned char line = 0;
+  for (unsigned char i = top; i != selected; i = Next(i)) line++;
+  for (; line >= LINES; line--) top = Next(top);
+}
+
+// A click on the selected item
+unsigned char Activate() {
+  Item item;
+  LoadItem(selected, &item);
+  if (item.step) {
+    DrawWaitKnobScreen(item.label, item.units);
+    SetWaitValues(item.min, item.max, item.step, item.Get(), item.Preview);
+    return STATE_WAIT_VALUE;
+  }
+  if (item.Set) item.Set(0);
+  if (item.flags & APP) return STATE_INITIAL;  // the app owns the screen now
+  if (item.flags & STAY) {
+    if (!Visible(top)) top = selected;
+    Select(0);
+    DrawList(true);
+    return STATE_SELECTING_MENU;
   }
-  return STATE_INITIAL;
+  return STATE_EXIT;
 }
 
 unsigned char StateWaitValue() {
-  int knob = encoder::ReadSlow();
+  int knob = encoder::Read(encoder::MENU);
 
   if (knob != 0) {
-    if (knob < 0) value.current -= value.step;
-    if (knob > 0) value.current += value.step;
-    value.current = (value.current - value.min)
-        / value.step * value.step
-        + value.min;
-    if (value.current < value.min) value.current = value.min;
-    if (value.current > value.max) value.current = value.max;
+    long current = value.current + (long)knob * value.step;
+    current = (current - value.min) / value.step * value.step + value.min;
+    if (current < value.min) current = value.min;
+    if (current > value.max) current = value.max;
+    value.current = current;
 
     if (value.PreviewCallback) value.PreviewCallback();
   }
 
   if (mainloop::buttons.f_clicked) {
     mainloop::buttons.f_clicked = false;
-    return STATE_VALUE_RETURNED;
+    Item item;
+    LoadItem(selected, &item);
+    item.Set(value.current);
+    return STATE_EXIT;
   }
   return STATE_WAIT_VALUE;
 }
 
+// Draws over whatever is on the screen, every tile of it, so entering
+// needs no clear. Leaving neither, the tuning screen does the same.
 void DoMenu() {
   static unsigned char state = STATE_INITIAL;
-  static unsigned char active_menu;
-  static int select; // encoder state
 
   switch (state) {
-    case STATE_INITIAL:  // init
-      select = 0;
-      active_menu = 0;
-      state = STATE_DRAW_SELECTED;
+    case STATE_INITIAL:
+      selected = top = 0;
+      DrawList(true);
+      state = STATE_SELECTING_MENU;
       break;
-    case STATE_DRAW_SELECTED:  // draw active menu item
-      state = CallMenuHandler(active_menu, EVENT_SELECTED);
-      // fall through
     case STATE_SELECTING_MENU: {  // wait encoder change to select other menu, or click to enter
       if (mainloop::buttons.f_clicked) {
         mainloop::buttons.f_clicked = false;
-        state = STATE_MENU_ITEM_ACTIVE;  // handle menu item inside
+        state = Activate();
         break;
       }
 
       if (mainloop::buttons.f_held) {
         mainloop::buttons.f_held = false;
-        state = STATE_EXIT;  // exit
+        state = STATE_EXIT;
         break;
       }
 
-      select += encoder::ReadSlow();
-      if (advanced_menu && select > 169) select = 169;
-      if (!advanced_menu && select > 79) select = 79;
-      if (select < 0) select = 0;
-
-      unsigned char new_active_menu = select / 10;
-      if (!advanced_menu && new_active_menu == 7) new_active_menu = 16;
-
-      if (new_active_menu != active_menu) { // menu changed
-        active_menu = new_active_menu;
-        state = STATE_DRAW_SELECTED;  // draw active menu item
-        break;
-      }
+      int knob = encoder::ReadSlow();
+      if (knob) Select(knob);
+      DrawList(false);
       break;
     }
-    case STATE_MENU_ITEM_ACTIVE: // entered menu item handling
-      state = CallMenuHandler(active_menu, EVENT_ACTIVE);
-      break;
     case STATE_WAIT_VALUE:
       state = StateWaitValue();
       break;
-    case STATE_VALUE_RETURNED:
-      state = CallMenuHandler(active_menu, EVENT_VALUE);
-      break;
-    case STATE_OPEN_ADVANCED:
-      advanced_menu = true;
-      select = 75;
-      active_menu = 7;
-      state = STATE_DRAW_SELECTED;
-      break;
-    case STATE_EXIT: // exit
-      // ui::u8x8.setInverseFont(1); TODO - where we do this now?
+    case STATE_EXIT:
       state = STATE_INITIAL;
-      ui::u8x8.clear();
       mainloop::DoActiveApp = mainloop::DoTuning;
       break;
   }
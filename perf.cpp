@@ -0,0 +1,202 @@
+#include "perf.h"
+#include <Arduino.h>
+#include "i2c.h"
+#include "power.h"
+#include "sched.h"
+
+namespace perf {
+
+// Entry i of a PROGMEM table of flash strings, for Serial.print()
+const __FlashStringHelper *Name(const char *const *table, unsigned char i) {
+  return (const __FlashStringHelper *)pgm_read_ptr(table + i);
+}
+
+#if PERF_ENABLED
+const char NAME_KNOB[] PROGMEM = "KNOB";
+const char NAME_SYNTH[] PROGMEM = "SYN";
+const char NAME_RF[] PROGMEM = "RF";
+const char NAME_DISP[] PROGMEM = "DISP";
+const char NAME_PTT[] PROGMEM = "PTT";
+const char *const NAMES[SERIES] PROGMEM = {
+  NAME_KNOB, NAME_SYNTH, NAME_RF, NAME_DISP, NAME_PTT};
+
+Stats stats[SERIES];
+unsigned int start[SERIES];
+unsigned char running = 0;    // series started and not ended yet
+unsigned char wait_bus = 0;   // series to end when the bus goes idle
+#endif
+
+#if PERF_PROFILE
+const char NAME_CAT[] PROGMEM = "CAT";
+const char NAME_KEYER[] PROGMEM = "KEY";
+const char NAME_BUTTONS[] PROGMEM = "BTN";
+const char NAME_TUNING[] PROGMEM = "TUNE";
+const char NAME_MENU[] PROGMEM = "MENU";
+const char NAME_TX[] PROGMEM = "TX";
+const char NAME_SETFREQ[] PROGMEM = "SYN";
+const char NAME_DRAW[] PROGMEM = "DRAW";
+const char *const SECTION_NAMES[SECTIONS] PROGMEM = {
+  NAME_CAT, NAME_KEYER, NAME_BUTTONS, NAME_TUNING, NAME_MENU, NAME_TX,
+  NAME_SETFREQ, NAME_DRAW};
+
+Profile profile[SECTIONS];
+#endif
+
+void Init() {
+  if (!ENABLED && !PROFILE) return;
+  TCCR1A = 0;
+  TCCR1B = _BV(CS11) | _BV(CS10);  // free running at F_CPU / 64
+#if PERF_ENABLED
+  for (unsigned char i = 0; i < SERIES; i++) stats[i].min = 0xffff;
+#endif
+}
+
+#if PERF_ENABLED
+
+void DoBegin(unsigned char mask, unsigned int t) {
+  unsigned char sreg = SREG;
+  cli();
+  mask &= ~running;
+  running |= mask;
+  for (unsigned char i = 0; i < SERIES; i++) {
+    if (mask & _BV(i)) start[i] = t;
+  }
+  SREG = sreg;
+}
+
+// Callers other than the interrupts have them off already
+void Record(unsigned char series) {
+  if (!(running & _BV(series))) return;
+  running &= ~_BV(series);
+  Stats *s = &stats[series];
+  if (s->count == 0xffff) return;
+  unsigned int dt = TCNT1 - start[series];
+  s->count++;
+  s->sum += dt;
+  if (dt < s->min) s->min = dt;
+  if (dt > s->max) s->max = dt;
+  unsigned char bucket = 0;
+  for (dt >>= 3; dt && bucket < 7; dt >>= 2) bucket++;
+  s->hist[bucket]++;
+}
+
+void DoEnd(unsigned char series) {
+  unsigned char sreg = SREG;
+  cli();
+  Record(series);
+  SREG = sreg;
+}
+
+void DoEndOnBus(unsigned char series) {
+  unsigned char sreg = SREG;
+  cli();
+  if (i2c::Sending(i2c::PRIO_HIGH)) wait_bus |= _BV(series);
+  else Record(series);
+  SREG = sreg;
+}
+
+void Get(unsigned char series, Stats *s) {
+  unsigned char sreg = SREG;
+  cli();
+  *s = stats[series];
+  SREG = sreg;
+}
+#endif
+
+// From the TWI interrupt when the synthesizer queue has run empty
+void BusIdle() {
+#if PERF_ENABLED
+  for (unsigned char i = 0; i < SERIES; i++) {
+    if (wait_bus & _BV(i)) Record(i);
+  }
+  wait_bus = 0;
+#endif
+}
+
+#if PERF_PROFILE
+
+void Halve(Profile *p) {
+  p->count >>= 1;
+  p->total >>= 1;
+  for (unsigned char i = 0; i < 16; i++) p->hist[i] >>= 1;
+}
+
+void DoLeave(unsigned char section, unsigned int start) {
+  unsigned int dt = TCNT1 - start;
+  unsigned char bucket = 0;
+  for (unsigned int d = dt >> 1; d; d >>= 1) bucket++;
+  unsigned char sreg = SREG;
+  cli();
+  Profile *p = &profile[section];
+  if (p->count == 0xffff || p->hist[bucket] == 0xff) Halve(p);
+  p->count++;
+  p->total += dt;
+  if (dt > p->max) p->max = dt;
+  p->hist[bucket]++;
+  SREG = sreg;
+}
+
+void GetProfile(unsigned char section, Profile *p) {
+  unsigned char sreg = SREG;
+  cli();
+  *p = profile[section];
+  SREG = sreg;
+}
+
+#endif
+
+// One line per series, times in us:
+// name count min avg max  then the histogram buckets
+// and per profiled section:
+// name count avg max  then the log2 histogram
+// then the scheduler tasks (sched::Dump())
+// and last the share of the CPU not asleep, in %
+void Dump() {
+#if PERF_PROFILE
+  Profile p;
+  for (unsigned char i = 0; i < SECTIONS; i++) {
+    GetProfile(i, &p);
+    Serial.print(Name(SECTION_NAMES, i));
+    Serial.print(' ');
+    Serial.print(p.count);
+    Serial.print(' ');
+    Serial.print(p.count ? p.total / p.count * 4 : 0);
+    Serial.print(' ');
+    Serial.print(p.max * 4ul);
+    for (unsigned char j = 0; j < 16; j++) {
+      Serial.print(' ');
+      Serial.print(p.hist[j]);
+    }
+    Serial.println();
+  }
+#endif
+
+#if PERF_ENABLED
+  Stats s;
+  for (unsigned char i = 0; i < SERIES; i++) {
+    Get(i, &s);
+    Serial.print(Name(NAMES, i));
+    Serial.print(' ');
+    Serial.print(s.count);
+    if (s.count) {
+      Serial.print(' ');
+      Serial.print(s.min * 4ul);
+      Serial.print(' ');
+      Serial.print(s.sum / s.count * 4);
+      Serial.print(' ');
+      Serial.print(s.max * 4ul);
+    }
+    for (unsigned char j = 0; j < 8; j++) {
+      Serial.print(' ');
+      Serial.print(s.hist[j]);
+    }
+    Serial.println();
+  }
+#endif
+
+  sched::Dump();
+  Serial.print(F("BUSY "));
+  Serial.println(power::BusyPercent());
+}
+
+}  // namespace
@@ -0,0 +1,122 @@
+#ifndef UBITX_PERF_H_
+#define UBITX_PERF_H_
+
+#include <Arduino.h>
+
+// Build switches for the instrumentation below. Left at 0 its tables,
+// the perf menu entry and the CAT profile opcode are not compiled in.
+#ifndef PERF_ENABLED
+#define PERF_ENABLED 0
+#endif
+#ifndef PERF_PROFILE
+#define PERF_PROFILE 0
+#endif
+
+namespace perf {
+
+/**
+ * Latency instrumentation. A series is started by one event (an encoder
+ * edge, the PTT going down) and ended by a later one, the time between
+ * them is taken from Timer1 running free at F_CPU / 64, so 4 us ticks
+ * and at most 262 ms. With ENABLED false every hook compiles to nothing.
+ */
+const bool ENABLED = PERF_ENABLED;
+
+enum Series {
+  KNOB,     // encoder edge .. DoTuning() picks it up
+  SYNTH,    // si5351::SetFreq() entry .. exit
+  RF,       // encoder edge .. Si5351 writes done on the bus
+  DISP,     // encoder edge .. the next display frame queued
+  PTT,      // PTT debounced .. TX_RX high and the TX image on the bus
+  SERIES
+};
+
+struct Stats {
+  unsigned int count;
+  unsigned int min;
+  unsigned int max;
+  unsigned long sum;
+  unsigned int hist[8];     // < 32 us, < 128 us ... 4x per bucket
+};
+
+extern const char *const NAMES[SERIES];  // PROGMEM table of PROGMEM strings
+
+void Init();
+void Get(unsigned char series, Stats *s);
+void Dump();
+
+void DoBegin(unsigned char mask, unsigned int t);
+void DoEnd(unsigned char series);
+void DoEndOnBus(unsigned char series);
+void BusIdle();
+
+inline unsigned int Now() {
+  return ENABLED ? TCNT1 : 0;
+}
+
+// Start all series in mask that are not running yet
+inline void Begin(unsigned char mask, unsigned int t = Now()) {
+#if PERF_ENABLED
+  DoBegin(mask, t);
+#endif
+}
+
+inline void End(unsigned char series) {
+#if PERF_ENABLED
+  DoEnd(series);
+#endif
+}
+
+// End once the synthesizer writes queued so far have gone out
+inline void EndOnBus(unsigned char series) {
+#if PERF_ENABLED
+  DoEndOnBus(series);
+#endif
+}
+
+/**
+ * Section profiler on the same Timer1 ticks: how often a piece of code
+ * ran, how long in total and at most, and a log2 histogram of its run
+ * times. With PROFILE false the hooks compile to nothing.
+ */
+const bool PROFILE = PERF_PROFILE;
+
+enum Section {
+  P_CAT,      // cat::Run()
+  P_KEYER,    // keyer::Run()
+  P_BUTTONS,  // button sampling interrupt
+  P_TUNING,   // the active app ...
+  P_MENU,
+  P_TX,
+  P_SETFREQ,  // si5351::SetFreq() / SetFreqPll()
+  P_DRAW,     // display frames and the voltage readout
+  SECTIONS
+};
+
+// Counters are halved together when one would overflow, so the average
+// and the shape of the histogram survive long runs
+struct Profile {
+  unsigned int count;
+  unsigned long total;      // ticks
+  unsigned int max;         // ticks
+  unsigned char hist[16];   // bucket n holds runs of 2^n .. 2^(n+1)-1 ticks
+};
+
+extern const char *const SECTION_NAMES[SECTIONS];  // PROGMEM as NAMES
+
+void DoLeave(unsigned char section, unsigned int start);
+void GetProfile(unsigned char section, Profile *p);
+
+inline unsigned int Enter() {
+  return PROFILE ? TCNT1 : 0;
+}
+
+inline void Leave(unsigned char section, unsigned int start) {
+#if PERF_PROFILE
+  DoLeave(section, start);
+#endif
+}
+
+}  // namespace
+
+#endif  // UBITX_PERF_H_
@@ -0,0 +1,67 @@
+#include "power.h"
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include "si5351.h"
+#include "ubitx.h"
+#include "ui.h"
+
+namespace power {
+
+volatile bool activity = false;
+
+unsigned long last_activity = 0;
+bool blanked = false;
+
+unsigned long window_start = 0;   // millis()
+unsigned long asleep_us = 0;      // in the current window
+unsigned char busy_percent = 100;
+
+// The display keeps its contents while switched off and the Si5351 its
+// frequencies, waking only needs the panel and the outputs back on
+void DeepIdle(unsigned long now) {
+  if (activity || ubitx::in_tx) {
+    activity = false;
+    last_activity = now;
+    Wake();
+  } else if (!blanked && now - last_activity >= DEEP_IDLE_MS) {
+    blanked = true;
+    si5351::PowerDown(DEEP_IDLE_CLOCKS);
+    ui::SetPowerSave(true);
+  }
+}
+
+void Wake() {
+  if (!blanked) return;
+  blanked = false;
+  si5351::PowerDown(0);
+  ui::SetPowerSave(false);
+}
+
+// From the scheduler when no task was due
+void Idle() {
+  unsigned long now = millis();
+  if (DEEP_IDLE) DeepIdle(now);
+
+  if (now - window_start >= 1000) {
+    unsigned long window_us = (now - window_start) * 1000;
+    unsigned long idle_percent = asleep_us / (window_us / 100);
+    busy_percent = idle_percent < 100 ? 100 - idle_percent : 0;
+    window_start = now;
+    asleep_us = 0;
+  }
+
+  unsigned long start = micros();
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  cli();
+  sleep_enable();
+  sei();                            // takes effect after the next instruction,
+  sleep_cpu();                      // so no wake up is lost in between
+  sleep_disable();
+  asleep_us += micros() - start;
+}
+
+unsigned char BusyPercent() {
+  return busy_percent;
+}
+
+}  // namespace
@@ -0,0 +1,42 @@
+#ifndef UBITX_POWER_H_
+#define UBITX_POWER_H_
+
+namespace power {
+
+/**
+ * Idle handling. When the scheduler finds nothing due the CPU sleeps in
+ * SLEEP_MODE_IDLE, the timers, the UART and the pin change interrupts
+ * keep running and any of them wakes it. The time asleep gives the busy
+ * share of the CPU per second.
+ *
+ * With DEEP_IDLE the display is also switched off after DEEP_IDLE_MS
+ * without any use of the radio, and the DEEP_IDLE_CLOCKS outputs of the
+ * Si5351 are powered down: the carrier oscillator CLK0 and the second
+ * oscillator CLK1 that the transmitter mixes with. The receiver is quiet
+ * until the first encoder step, button, CAT command, radio change or PTT
+ * brings both back.
+ *
+ * Waking costs up to one scheduler tick until Idle() sees the activity,
+ * then two Si5351 writes (the CLK control registers and the output
+ * enable, about 0.2 ms at 400 kHz) ahead of the display command. The
+ * PLLs and multisynths keep running, so the outputs come back on the old
+ * frequency without a PLL reset. PTT wakes before the tx image goes out.
+ */
+const bool DEEP_IDLE = false;
+const unsigned long DEEP_IDLE_MS = 300000;
+const unsigned char DEEP_IDLE_CLOCKS = 1 << 0 | 1 << 1;
+
+extern volatile bool activity;
+
+// Safe from interrupts
+inline void Activity() {
+  activity = true;
+}
+
+void Idle();
+void Wake();                  // out of deep idle now, not from interrupts
+unsigned char BusyPercent();  // over the last whole second
+
+}  // namespace
+
+#endif  // UBITX_POWER_H_
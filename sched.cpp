@@ -0,0 +1,77 @@
+#include "sched.h"
+#include <Arduino.h>
+#include "power.h"
+#include "watchdog.h"
+
+namespace sched {
+
+Task tasks[MAX_TASKS];        // kept sorted by priority
+unsigned char task_count = 0;
+volatile unsigned char current = NONE;
+unsigned long started;
+
+void Add(PGM_P name, void (*run)(), unsigned int period,
+         unsigned char priority, unsigned int budget, bool (*ready)()) {
+  if (task_count == MAX_TASKS) return;
+  unsigned char i = task_count++;
+  for (; i > 0 && tasks[i - 1].priority > priority; i--) tasks[i] = tasks[i - 1];
+  Task *t = &tasks[i];
+  memset(t, 0, sizeof(*t));
+  t->name = name;
+  t->Run = run;
+  t->Ready = ready;
+  t->period = period;
+  t->budget = budget;
+  t->priority = priority;
+  t->next = millis();
+}
+
+void Run() {
+  watchdog::Feed();
+  unsigned long now = millis();
+  for (unsigned char i = 0; i < task_count; i++) {
+    Task *t = &tasks[i];
+    if (t->period) {
+      if ((long)(now - t->next) < 0) continue;
+      if (now - t->next >= t->period) {  // missed a whole period, skip ahead
+        if (t->late != 0xffff) t->late++;
+        t->next = now;
+      }
+      t->next += t->period;
+    } else if (!t->Ready()) {
+      continue;
+    }
+
+    started = now;
+    current = i;
+    unsigned long start = micros();
+    t->Run();
+    unsigned long took = micros() - start;
+    current = NONE;
+    watchdog::Rearm();
+    if (took > 0xffff) took = 0xffff;
+    if (took > t->max_us) t->max_us = took;
+    if (took > t->budget && t->overruns != 0xffff) t->overruns++;
+    if (t->runs != 0xffff) t->runs++;
+    return;  // start over from the most urgent task
+  }
+  power::Idle();  // nothing due, sleep until the next interrupt
+}
+
+// One line per task: name runs overruns late max_us
+void Dump() {
+  for (unsigned char i = 0; i < task_count; i++) {
+    const Task *t = &tasks[i];
+    Serial.print((const __FlashStringHelper *)t->name);
+    Serial.print(' ');
+    Serial.print(t->runs);
+    Serial.print(' ');
+    Serial.print(t->overruns);
+    Serial.print(' ');
+    Serial.print(t->late);
+    Serial.print(' ');
+    Serial.println(t->max_us);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,48 @@
+#ifndef UBITX_SCHED_H_
+#define UBITX_SCHED_H_
+
+#include <avr/pgmspace.h>
+
+namespace sched {
+
+/**
+ * Cooperative scheduler that replaces the bare loop(). Every pass of Run()
+ * starts only the highest priority task that is due, so however long a
+ * display frame takes, the keyer and CAT are next in line when it ends.
+ * A periodic task is due every period ms, an event task (period 0)
+ * whenever its Ready() says so. A run taking longer than the budget
+ * counts as an overrun, a periodic task starting a whole period after
+ * it was due counts as late. A pass with nothing due sleeps until the
+ * next interrupt.
+ */
+struct Task {
+  PGM_P name;
+  void (*Run)();
+  bool (*Ready)();          // event tasks only
+  unsigned int period;      // ms, 0 for an event task
+  unsigned int budget;      // us
+  unsigned char priority;   // 0 is the most urgent
+  unsigned long next;       // millis() when due
+  unsigned int runs;         // the counters stop at 0xffff
+  unsigned int overruns;
+  unsigned int late;
+  unsigned int max_us;
+};
+
+const unsigned char MAX_TASKS = 5;  // the ones setup() adds, 23 bytes of RAM each
+
+const unsigned char NONE = 0xff;
+
+extern Task tasks[MAX_TASKS];
+extern unsigned char task_count;
+extern volatile unsigned char current;  // task running now or NONE
+extern unsigned long started;           // millis() when it started
+
+void Add(PGM_P name, void (*run)(), unsigned int period,
+         unsigned char priority, unsigned int budget, bool (*ready)() = 0);
+void Run();
+void Dump();
+
+}  // namespace
+
+#endif  // UBITX_SCHED_H_
@@ -0,0 +1,115 @@
+#include "scope.h"
+#include <Arduino.h>
+#include "encoder.h"
+#include "hw.h"
+#include "mainloop.h"
+#include "power.h"
+#include "ubitx.h"
+#include "ui.h"
+
+namespace scope {
+
+// Whole span in Hz, the points are SPAN / POINTS apart
+const unsigned long SPAN[SPANS] PROGMEM = {16000, 32000, 64000, 128000, 256000, 512000};
+
+const unsigned char GRAPH_TOP = 2;  // below the header
+const unsigned char GRAPH_HEIGHT = (ui::ROWS - GRAPH_TOP) * 8;
+
+unsigned char span = 2;
+unsigned char point;
+unsigned long start_f;        // frequency of point 0
+unsigned int step;
+unsigned long sweep_start;    // millis()
+unsigned int points_per_s = 0;
+
+// Span and the rate of the last sweep, "SPAN 64K    480/S"
+void DrawHeader() {
+  char label[10];
+  char rate[8] = "";
+  strcpy_P(label, PSTR("SPAN "));
+  ultoa(pgm_read_dword(SPAN + span) / 1000, label + 5, 10);
+  strcat_P(label, PSTR("K"));
+  if (points_per_s) {
+    utoa(points_per_s, rate, 10);
+    strcat_P(rate, PSTR("/S"));
+  }
+  ui::PrintLineValue(0, label, rate);
+}
+
+// A sweep follows the dial, should CAT move it meanwhile
+void StartSweep() {
+  unsigned long width = pgm_read_dword(SPAN + span);
+  step = width / POINTS;
+  start_f = ubitx::frequency - width / 2;
+  point = 0;
+  sweep_start = millis();
+  ubitx::TuneFast(start_f);
+}
+
+// The level 0..1023 on the graph, weak signals still show a pixel
+unsigned char Height(int level) {
+  return 1 + (unsigned long)level * (GRAPH_HEIGHT - 1) / 1024;
+}
+
+// The tuning screen draws over all of it
+void Exit() {
+  ui::ReleaseGraph();
+  ubitx::RestoreDial();
+  mainloop::DoActiveApp = mainloop::DoTuning;
+}
+
+void DoScope() {
+  enum DO_SCOPE_STATES {
+    STATE_INITIAL,
+    STATE_SWEEP
+  };
+  static unsigned char state = STATE_INITIAL;
+
+  if (mainloop::buttons.ptt_down || ubitx::in_tx) {
+    state = STATE_INITIAL;  // the tuning screen takes the ptt from here
+    Exit();
+    return;
+  }
+
+  switch (state) {
+    case STATE_INITIAL:
+      ui::ClearGraph(GRAPH_TOP);  // with the header that is every tile
+      points_per_s = 0;
+      DrawHeader();
+      StartSweep();
+      state = STATE_SWEEP;
+      break;
+    case STATE_SWEEP: {
+      if (mainloop::buttons.f_clicked) {
+        mainloop::buttons.f_clicked = false;
+        state = STATE_INITIAL;
+        Exit();
+        break;
+      }
+
+      int knob = encoder::ReadSlow();
+      if (knob) {
+        int s = span + knob;
+        span = s < 0 ? 0 : s >= SPANS ? SPANS - 1 : s;
+        points_per_s = 0;
+        DrawHeader();
+        StartSweep();
+        break;
+      }
+
+      // The point tuned on the last run had a scheduler tick to settle
+      ui::DrawBar(point, Height(analogRead(hw::SMETER)));
+      if (++point == POINTS) {
+        points_per_s = POINTS * 1000ul / (millis() - sweep_start + 1);
+        DrawHeader();
+        power::Activity();  // looking at the scope is using the radio
+        StartSweep();
+      } else {
+        ubitx::TuneFast(start_f + (unsigned long)point * step);
+      }
+      break;
+    }
+  }
+}
+
+}  // namespace
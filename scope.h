@@ -0,0 +1,20 @@
+#ifndef UBITX_SCOPE_H_
+#define UBITX_SCOPE_H_
+
+namespace scope {
+
+/**
+ * Band scope, an app for mainloop::DoActiveApp. Sweeps the receiver over
+ * SPAN around the dial one point per run, reads the S-meter voltage on
+ * hw::SMETER at each and draws it as one bar of a 128 column graph.
+ * The knob picks the span, a click, PTT or any transmit ends it and the
+ * receiver goes back to the dial exactly.
+ */
+const unsigned char POINTS = 128;
+const unsigned char SPANS = 6;
+
+void DoScope();
+
+}  // namespace
+
+#endif  // UBITX_SCOPE_H_
@@ -1,6 +1,7 @@
 #include "si5351.h"
 #include <Arduino.h>
-#include <Wire.h>
+#include "i2c.h"
+#include "perf.h"
 
 namespace si5351 {
 
@@ -10,12 +11,16 @@ namespace si5351 {
 // VCOA is fixed at 875mhz, VCOB not used.
 // The output msynth dividers are used to generate 3 independent clocks
 // with 1hz resolution to any frequency between 4khz and 109mhz.
+// Alternatively SetFreqPll() moves one clock onto VCOB behind a fixed
+// even integer output divider and tunes it by retuning VCOB itself.
 
 // Usage:
 // Call si5351bx_init() once at startup with no args;
 // Call si5351bx_setfreq(clknum, freq) each time one of the
 // three output CLK pins is to be updated to a new frequency.
 // A freq of 0 serves to shut down that output clock.
+// To retune several clocks at once wrap the calls in Begin() / Commit(),
+// the changes then go out together when the outermost Commit() is reached.
 
 // The global variable si5351bx_vcoa starts out equal to the nominal VCOA
 // frequency of 25mhz*35 = 875000000 Hz.  To correct for 25mhz crystal errors,
@@ -49,28 +54,55 @@ namespace si5351 {
 unsigned long si5351bx_vcoa = (SI5351BX_XTAL*SI5351BX_MSA);  // 25mhzXtal calibrate
 char  si5351bx_rdiv = 0;             // 0-7, CLK pin sees fout/(2**rdiv)
 char  si5351bx_drive[3] = {3, 3, 3}; // 0=2ma 1=4ma 2=6ma 3=8ma for CLK 0,1,2
-char  si5351bx_clken = 0xFF;         // Private, all CLK output drivers off
 
+// Register image of the outputs as SetFreq() wants them, and a shadow copy of
+// what the chip holds. Commit() diffs the two and sends only the smallest
+// changed contiguous range of each register block, so a 50 Hz step usually
+// costs 1-3 bytes and a VFO + BFO retune a single multisynth burst.
+Image image = {(char)0xFF,           // all CLK output drivers off
+               {(char)0x80, (char)0x80, (char)0x80}};  // CLK's powered down
+Image shadow;
+unsigned char transaction_depth = 0; // nesting of Begin() .. Commit()
+unsigned char powered_down = 0;      // CLKs held down whatever the image says
+
+unsigned long xtal = SI5351BX_XTAL;  // calibrated crystal, si5351bx_vcoa / MSA
+
+// Writes are queued on the shared bus ahead of any display traffic and
+// go out from the TWI interrupt, the callers do not wait for them.
 void i2cWrite(char reg, char val) {   // write reg via i2c
-  Wire.beginTransmission(SI5351BX_ADDR);
-  Wire.write(reg);
-  Wire.write(val);
-  Wire.endTransmission();
+  i2c::Begin(SI5351BX_ADDR, i2c::PRIO_HIGH);
+  i2c::Write(reg);
+  i2c::Write(val);
+  i2c::End();
 }
 
 void i2cWriten(char reg, char *vals, char vcnt) {  // write array
-  Wire.beginTransmission(SI5351BX_ADDR);
-  Wire.write(reg);
-  while (vcnt--) Wire.write(*vals++);
-  Wire.endTransmission();
+  while (vcnt > 0) {                    // in records the queue can take
+    char n = vcnt < i2c::MAX_HIGH - 1 ? vcnt : i2c::MAX_HIGH - 1;
+    vcnt -= n;
+    i2c::Begin(SI5351BX_ADDR, i2c::PRIO_HIGH);
+    i2c::Write(reg);
+    reg += n;
+    while (n--) i2c::Write(*vals++);
+    i2c::End();
+  }
+}
+
+void i2cWriteCached(char reg, char *vals, char *shadow, unsigned char vcnt) {
+  unsigned char first = 0, last = vcnt;
+  while (first < last && vals[first] == shadow[first]) first++;
+  if (first == last) return;            // chip already holds these values
+  while (vals[last - 1] == shadow[last - 1]) last--;
+  memcpy(shadow + first, vals + first, last - first);
+  i2cWriten(reg + first, vals + first, last - first);
 }
 
 
 void Init() {                  // Call once at power-up, start PLLA
   unsigned long msxp1;
-  Wire.begin();
+  i2c::SetClock(SI5351BX_ADDR, 400000);
   i2cWrite(149, 0);                     // SpreadSpectrum off
-  i2cWrite(3, si5351bx_clken);          // Disable all CLK output drivers
+  i2cWrite(3, image.clken);             // Disable all CLK output drivers
   i2cWrite(183, SI5351BX_XTALPF << 6);  // Set 25mhz crystal load capacitance
   msxp1 = 128 * SI5351BX_MSA - 512;     // and msxp2=0, msxp3=1, not fractional
   char  vals[8] = {0, 1, BB2(msxp1), BB1(msxp1), BB0(msxp1), 0, 0, 0};
@@ -79,43 +111,219 @@ void Init() {                  // Call once at power-up, start PLLA
   // for (reg=16; reg<=23; reg++) i2cWrite(reg, 0x80);    // Powerdown CLK's
   // i2cWrite(187, 0);                  // No fannout of clkin, xtal, ms0, ms4
 
-  //initializing the ppl2 as well
-  i2cWriten(34, vals, 8);               // Write to 8 PLLA msynth regs
+  //initializing the ppl2 as well, unless a clock is being tuned with it
+  if (!image.pllb_div) memcpy(image.pllb, vals, 8);
+  i2cWriten(34, image.pllb, 8);         // Write to 8 PLLB msynth regs
   i2cWrite(177, 0xa0);                  // Reset PLLA  & PPLB (0x80 resets PLLB)
 
+  // Bring the chip in line with the image; after a recalibration this puts
+  // back the running outputs, at power-up it powers them down.
+  i2cWriten(42, image.ms, sizeof(image.ms));
+  i2cWriten(16, image.ctrl, sizeof(image.ctrl));
+  shadow = image;
+}
+
+void Begin() {
+  transaction_depth++;
+}
+
+void Commit() {
+  if (--transaction_depth) return;      // an outer Begin() is still open
+  i2cWriteCached(34, image.pllb, shadow.pllb, sizeof(image.pllb));
+  i2cWriteCached(42, image.ms, shadow.ms, sizeof(image.ms));
+  char ctrl[3], clken = image.clken | powered_down;
+  for (unsigned char i = 0; i < 3; i++)
+    ctrl[i] = powered_down & 1 << i ? image.ctrl[i] | 0x80 : image.ctrl[i];
+  i2cWriteCached(16, ctrl, shadow.ctrl, sizeof(ctrl));
+  i2cWriteCached(3, &clken, &shadow.clken, 1);  // Enable/disable clocks
+  if (image.pllb_div != shadow.pllb_div) {
+    i2cWrite(177, 0x80);                // Reset PLLB after a divider change
+    shadow.pllb_div = image.pllb_div;
+  }
+}
+
+// The multisynths keep their settings, powering back up only takes the
+// control and enable registers.
+void PowerDown(unsigned char mask) {
+  Begin();
+  powered_down = mask;
+  Commit();
+}
+
+void SaveImage(Image *img) {
+  *img = image;
+}
+
+void LoadImage(const Image *img) {
+  Begin();
+  image = *img;
+  Commit();
+}
+
+// What has been sent to the chip, for checking the synthesizer from a PC.
+void ReadChip(Image *img) {
+  *img = shadow;
+}
+
+/**
+ * Quotient and remainder of the last num / den done for one divider.
+ * Tuning steps move num or den by a few Hz, so the quotient barely changes
+ * and the new remainder can be corrected from the old one without a
+ * 32 bit long division (several hundred cycles on the ATmega328P).
+ */
+struct DivCache {
+  unsigned long num;
+  unsigned long den;
+  unsigned long quot;
+  unsigned long rem;
+};
+
+DivCache div_cache[4];               // shared by the CLKs, num is always the vco
+unsigned char div_next = 0;          // entry to recycle next
+DivCache pllb_cache;                 // VCOB / xtal, den is always the xtal
+
+// The cache entry nearest to fout if that is within 512 kHz, else a
+// recycled one. Clocks that close share an entry, the remainder correction
+// covers the difference. Taking the nearest rather than the first entry in
+// range stops the RX and TX VFOs from taking turns on an entry meant for
+// the other, so refreshing the images does not force long divisions.
+DivCache *CacheFor(unsigned long fout) {
+  DivCache *nearest = 0;
+  unsigned long nearest_dd = 0x80000;
+  for (unsigned char i = 0; i < 4; i++) {
+    long dd = fout - div_cache[i].den;
+    unsigned long dist = dd < 0 ? -dd : dd;
+    if (dist < nearest_dd) {
+      nearest = &div_cache[i];
+      nearest_dd = dist;
+    }
+  }
+  if (nearest) return nearest;
+  DivCache *c = &div_cache[div_next];
+  div_next = (div_next + 1) & 3;
+  c->den = 0;                        // forces a full division
+  return c;
+}
+
+void DivMod(DivCache *c, unsigned long num, unsigned long den) {
+  // num = quot * den + rem still holds for the old values, so the new
+  // remainder is off by (num - c->num) - quot * (den - c->den)
+  long delta = 0x7fffffff;
+  long dd = den - c->den;
+  if (c->den && c->quot < 0x800 && dd > -0x80000 && dd < 0x80000)
+    delta = (long)(num - c->num) - (long)c->quot * dd;
+  if (delta > -(long)(den << 2) && delta < (long)(den << 2)) {
+    long rem = (long)c->rem + delta;  // at most 4 corrections below
+    while (rem < 0) {
+      rem += den;
+      c->quot--;
+    }
+    while (rem >= (long)den) {
+      rem -= den;
+      c->quot++;
+    }
+    c->rem = rem;
+  } else {
+    c->quot = num / den;
+    c->rem = num % den;
+  }
+  c->num = num;
+  c->den = den;
+}
+
+// Write a + b / c (b < c) into 8 msynth parameter registers.
+void EncodeMs(char *vals, unsigned long a, unsigned long b, unsigned long c) {
+  unsigned long msxp1, msxp2, msxp3p2top;
+  while (c & 0xfff00000) {   // Divide by 2 till fits in reg
+    b = b >> 1;
+    c = c >> 1;
+  }
+  // 128 * b / c by shift and subtract, b < c so the quotient
+  // fits in 7 bits and what is left over in b is msxp2
+  unsigned char frac = 0;
+  for (unsigned char i = 0; i < 7; i++) {
+    b <<= 1;
+    frac <<= 1;
+    if (b >= c) {
+      b -= c;
+      frac |= 1;
+    }
+  }
+  msxp1 = 128 * a + frac - 512;
+  msxp2 = b;                 // msxp3 == c;
+  msxp3p2top = (((c & 0x0F0000) << 4) | msxp2);     // 2 top nibbles
+  vals[0] = BB1(c);
+  vals[1] = BB0(c);
+  vals[2] = BB2(msxp1);
+  vals[3] = BB1(msxp1);
+  vals[4] = BB0(msxp1);
+  vals[5] = BB2(msxp3p2top);
+  vals[6] = BB1(msxp2);
+  vals[7] = BB0(msxp2);
 }
 
 void SetFreq(unsigned char clknum, unsigned long fout) {  // Set a CLK to fout Hz
-  unsigned long  msa, msb, msc, msxp1, msxp2, msxp3p2top;
+  unsigned int prof = perf::Enter();
+  perf::Begin(_BV(perf::SYNTH));
+  Begin();
   if ((fout < 500000) || (fout > 109000000)) // If clock freq out of range
-    si5351bx_clken |= 1 << clknum;      //  shut down the clock
+    image.clken |= 1 << clknum;         //  shut down the clock
   else {
-    msa = si5351bx_vcoa / fout;     // Integer part of vco/fout
-    msb = si5351bx_vcoa % fout;     // Fractional part of vco/fout
-    msc = fout;             // Divide by 2 till fits in reg
-    while (msc & 0xfff00000) {
-      msb = msb >> 1;
-      msc = msc >> 1;
-    }
-    msxp1 = (128 * msa + 128 * msb / msc - 512) | (((unsigned long)si5351bx_rdiv) << 20);
-    msxp2 = 128 * msb - 128 * msb / msc * msc; // msxp3 == msc;
-    msxp3p2top = (((msc & 0x0F0000) << 4) | msxp2);     // 2 top nibbles
-    char vals[8] = { BB1(msc), BB0(msc), BB2(msxp1), BB1(msxp1),
-                        BB0(msxp1), BB2(msxp3p2top), BB1(msxp2), BB0(msxp2)
-                      };
-    i2cWriten(42 + (clknum * 8), vals, 8); // Write to 8 msynth regs
+    DivCache *c = CacheFor(fout);
+    DivMod(c, si5351bx_vcoa, fout);
+    // Integer and fractional part of vco/fout
+    EncodeMs(image.ms + clknum * 8, c->quot, c->rem, fout);
+    image.ms[clknum * 8 + 2] |= si5351bx_rdiv << 4;
+    if (image.ctrl[clknum] & 0x20) image.pllb_div = 0;  // clock leaves VCOB
 //    if (clknum == 1)      //PLLB | MS src | drive current
-//      i2cWrite(16 + clknum, 0x20 | 0x0C | si5351bx_drive[clknum]); // use local msynth   
+//      image.ctrl[clknum] = 0x20 | 0x0C | si5351bx_drive[clknum]; // use local msynth
 //    else
-      i2cWrite(16 + clknum, 0x0C | si5351bx_drive[clknum]); // use local msynth
-   
-    si5351bx_clken &= ~(1 << clknum);   // Clear bit to enable clock
+    image.ctrl[clknum] = 0x0C | si5351bx_drive[clknum];  // use local msynth
+
+    image.clken &= ~(1 << clknum);      // Clear bit to enable clock
+  }
+  Commit();
+  perf::End(perf::SYNTH);
+  perf::Leave(perf::P_SETFREQ, prof);
+}
+
+/**
+ * Set a CLK to fout Hz from VCOB. The output msynth stays at an even
+ * integer divider picked so that VCOB lands between 600 and 900 MHz, and
+ * only the VCOB feedback msynth is rewritten while fout stays in that
+ * window. Integer output division is the low jitter configuration, a
+ * tuning step costs a few bytes of PLLB registers, and the resolution is
+ * a few Hz instead of 1 Hz. Only one clock may be tuned this way.
+ */
+void SetFreqPll(unsigned char clknum, unsigned long fout) {
+  unsigned long vco;
+  unsigned int prof = perf::Enter();
+  perf::Begin(_BV(perf::SYNTH));
+  Begin();
+  if ((fout < 500000) || (fout > 109000000)) { // If clock freq out of range
+    image.clken |= 1 << clknum;         //  shut down the clock
+  } else {
+    vco = image.pllb_div * fout;
+    if (vco < 600000000 || vco > 900000000) {  // pick a new output divider
+      image.pllb_div = (600000000 / fout + 2) & ~1;
+      if (image.pllb_div < 8) image.pllb_div = 8;
+      vco = image.pllb_div * fout;
+      EncodeMs(image.ms + clknum * 8, image.pllb_div, 0, 1);
+    }
+    DivMod(&pllb_cache, vco, xtal);
+    EncodeMs(image.pllb, pllb_cache.quot, pllb_cache.rem, xtal);
+    // integer msynth | PLLB | MS src | drive current
+    image.ctrl[clknum] = 0x40 | 0x20 | 0x0C | si5351bx_drive[clknum];
+    image.clken &= ~(1 << clknum);      // Clear bit to enable clock
   }
-  i2cWrite(3, si5351bx_clken);        // Enable/disable clock
+  Commit();
+  perf::End(perf::SYNTH);
+  perf::Leave(perf::P_SETFREQ, prof);
 }
 
 void SetCalibration(long cal) {
   si5351bx_vcoa = (SI5351BX_XTAL * SI5351BX_MSA) + cal; // apply the calibration correction factor
+  xtal = si5351bx_vcoa / SI5351BX_MSA;
 }
 
 
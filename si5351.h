@@ -3,7 +3,29 @@
 
 namespace si5351 {
 
+/**
+ * The output related part of the register file. A caller can keep
+ * complete configurations ready made and switch between them with
+ * LoadImage(), which only sends the bytes that differ.
+ */
+struct Image {
+  char clken;              // register 3, output enable
+  char ctrl[3];            // registers 16..18, CLK0..CLK2 control
+  char ms[24];             // registers 42..65, MS0..MS2 parameters
+  char pllb[8];            // registers 34..41, PLLB feedback msynth
+  unsigned int pllb_div;   // even output divider of a PLLB tuned CLK, or 0
+};
+
+extern unsigned long si5351bx_vcoa;  // calibrated VCOA the dividers are computed for
+
+void Begin();
+void Commit();
 void SetFreq(unsigned char clknum, unsigned long fout);
+void SetFreqPll(unsigned char clknum, unsigned long fout);
+void PowerDown(unsigned char mask);  // bit n holds CLKn down, 0 restores
+void SaveImage(Image *img);
+void LoadImage(const Image *img);
+void ReadChip(Image *img);
 void SetCalibration(long cal);
 void Init();
 
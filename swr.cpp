@@ -0,0 +1,149 @@
+#include "swr.h"
+#include <Arduino.h>
+#include "hw.h"
+#include "ubitx.h"
+#include "ui.h"
+
+namespace swr {
+
+volatile bool high_swr = false;
+volatile bool sampling = false;
+
+// Written by the interrupt, the largest forward reading since the last
+// Draw() and the reflected one of the same pair
+volatile int forward_max = 0;
+volatile int reflected_at_max = 0;
+
+int forward;                // first half of the pair in progress
+unsigned char over = 0;     // pairs in a row above the limit
+
+const unsigned char METER_TOP = 6;        // rows 6 and 7
+const unsigned char BAR = 10;             // pixels
+const unsigned char PEAK = 16;
+const unsigned int DRAW_MS = 50;
+const unsigned int PEAK_HOLD_MS = 1000;
+
+bool meter_shown = false;                 // the graph rows are claimed
+unsigned long last_draw = 0;
+unsigned char peak = 0;                   // column
+unsigned long peak_time = 0;
+
+// ADC channel, AVcc reference like analogRead()
+void Select(unsigned char pin) {
+  ADMUX = _BV(REFS0) | ((pin - A0) & 7);
+}
+
+ISR(ADC_vect) {
+  int value = ADC;
+  if (ADMUX & 7) {          // reflected, the pair is complete
+    Select(hw::SWR_FWD);
+    ADCSRA |= _BV(ADSC);
+    if (forward >= forward_max) {
+      forward_max = forward;
+      reflected_at_max = value;
+    }
+    long limit = ubitx::settings.swr_limit;
+    if (forward >= MIN_FORWARD && 10l * (forward + value) > limit * (forward - value)) {
+      if (over < TRIP_PAIRS && ++over == TRIP_PAIRS) {
+        digitalWrite(hw::CW_KEY, 0);
+        digitalWrite(hw::TX_RX, 0);
+        ubitx::status.tx_inhibit = true;
+        high_swr = true;
+      }
+    } else if (over < TRIP_PAIRS) {
+      over = 0;             // a trip holds until Stop()
+    }
+  } else {
+    forward = value;
+    Select(hw::SWR_REF);
+    ADCSRA |= _BV(ADSC);
+  }
+}
+
+// From TxStart(), the transmitter is on
+void Start() {
+  high_swr = false;
+  over = 0;
+  forward_max = reflected_at_max = 0;
+  peak = 0;
+  meter_shown = false;
+  sampling = true;
+  Select(hw::SWR_FWD);
+  ADCSRA |= _BV(ADIE) | _BV(ADSC);
+}
+
+// From TxStop(). A conversion still running ends without an interrupt.
+void Stop() {
+  ADCSRA &= ~_BV(ADIE);
+  sampling = false;
+  if (over == TRIP_PAIRS) ubitx::status.tx_inhibit = false;
+}
+
+bool Sampling() {
+  return sampling;
+}
+
+// "SWR 1.5", "SWR  HI" over 9.9 and "SWR  --" without power, inverted
+// "HIGH SWR" once tripped
+void DrawSwr(int f, int r) {
+  if (over == TRIP_PAIRS) {
+    ui::SetInverse(true);
+    ui::Draw1x2String_P(1, 1, PSTR("HIGH SWR"));
+    ui::SetInverse(false);
+    return;
+  }
+  char b[9];
+  strcpy_P(b, PSTR("SWR  -- "));
+  if (f >= MIN_FORWARD) {
+    unsigned int tenths = f > r ? 10ul * (f + r) / (f - r) : 100;
+    if (tenths > 99) {
+      b[5] = 'H';
+      b[6] = 'I';
+    } else {
+      b[4] = '0' + tenths / 10;
+      b[5] = '.';
+      b[6] = '0' + tenths % 10;
+    }
+  }
+  ui::Draw1x2String(1, 1, b);
+}
+
+/**
+ * Forward power over the full width, the square of the voltage scaled to
+ * 128 columns, with the peak held for PEAK_HOLD_MS as a full height
+ * column. Every 16th column carries a scale tick. Only tiles that
+ * change are sent.
+ */
+void DrawPower(int f, unsigned long now) {
+  unsigned char columns = (unsigned long)f * f >> 13;  // 1023^2 >> 13 = 127
+  if (columns >= peak || now - peak_time > PEAK_HOLD_MS) {
+    peak = columns;
+    peak_time = now;
+  }
+  for (unsigned char c = 0; c < ui::COLUMNS * 8; c++) {
+    unsigned char h = c % 16 ? 1 : 3;
+    if (c < columns) h = BAR;
+    if (c == peak && peak) h = PEAK;
+    ui::DrawBar(c, h);
+  }
+}
+
+// From the tx apps, on every run
+void Draw() {
+  if (!sampling) return;
+  unsigned long now = millis();
+  if (meter_shown && now - last_draw < DRAW_MS) return;
+  if (!meter_shown) ui::ClearGraph(METER_TOP);
+  meter_shown = true;
+  last_draw = now;
+
+  cli();
+  int f = forward_max;
+  int r = reflected_at_max;
+  forward_max = 0;
+  sei();
+  DrawSwr(f, r);
+  DrawPower(f, now);
+}
+
+}  // namespace
@@ -0,0 +1,33 @@
+#ifndef UBITX_SWR_H_
+#define UBITX_SWR_H_
+
+namespace swr {
+
+/**
+ * SWR and forward power from a directional coupler, forward voltage on
+ * hw::SWR_FWD and reflected on hw::SWR_REF. While transmitting the ADC
+ * interrupt converts the two in turn, about 4800 pairs a second, and
+ * trips the transmitter off when TRIP_PAIRS pairs in a row are above the
+ * limit. The check is division free: with SWR = (f + r) / (f - r) the
+ * limit L in tenths is exceeded when 10 * (f + r) > L * (f - r). A trip
+ * drops TX_RX and CW_KEY right there and sets status.tx_inhibit until
+ * the transmission ends.
+ */
+const unsigned char TRIP_PAIRS = 4;       // about 1 ms
+const int MIN_FORWARD = 40;               // ADC counts, below this there is no reading
+const unsigned char LIMIT_MIN = 15;       // settings.swr_limit, tenths
+const unsigned char LIMIT_MAX = 99;
+const unsigned char LIMIT_DEFAULT = 30;
+
+// The last transmission tripped, for the CAT status. Cleared when the
+// next one starts.
+extern volatile bool high_swr;
+
+void Start();
+void Stop();
+bool Sampling();            // the ADC is busy, analogRead() would hang
+void Draw();                // the meter on the tx screen, rate limited
+
+}  // namespace
+
+#endif  // UBITX_SWR_H_
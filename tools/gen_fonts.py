@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Generate fonts_gen.h, the glyphs the display actually shows.
+
+Takes the glyphs from tools/glyphs.txt, or the two u8x8 fonts
+UI_U8X8_FONTS draws with out of the U8g2 sources, and keeps only the
+characters below. Text glyphs are stored already stretched to 1x2 and
+digits as their 2x3 tiles, 8 column bytes per tile in SSD1306 page
+order, so ui.cpp sends them as they are.
+
+    tools/gen_fonts.py tools/glyphs.txt > fonts_gen.h
+    tools/gen_fonts.py ~/Arduino/libraries/U8g2/src > fonts_gen.h
+
+The repo keeps the header made from tools/glyphs.txt, run this again
+after changing the glyphs or the lists below. The flash used is printed
+to stderr, from U8g2 sources also what the full fonts take, the time per
+glyph is in the perf menu benchmark (GLYPH line).
+"""
+import argparse
+import glob
+import os
+import re
+import sys
+
+TEXT_FONT = 'u8x8_font_amstrad_cpc_extended_u'
+DIGIT_FONT = 'u8x8_font_profont29_2x3_n'
+
+# Everything the menus and status lines print. Lower case is never shown.
+TEXT_CHARS = ' %+-./0123456789:=>ABCDEFGHIJKLMNOPQRSTUVWXYZ'
+DIGIT_CHARS = '-0123456789'
+
+MAP_FIRST = 32     # maps cover ' ' .. '_'
+MAP_SIZE = 64
+
+
+def load_font(src, name):
+    """The bytes of a u8x8 font from the U8g2 C sources."""
+    for path in glob.glob(os.path.join(src, '**', '*.c'), recursive=True):
+        text = open(path, encoding='latin-1').read()
+        m = re.search(r'\b%s\s*\[\s*\d*\s*\][^=;]*=' % re.escape(name), text)
+        if not m:
+            continue
+        # adjacent string literals up to the ';', which may also be data
+        literal = re.match(r'(?:\s*"(?:[^"\\]|\\.)*")+', text[m.end():]).group(0)
+        body = ''.join(re.findall(r'"((?:[^"\\]|\\.)*)"', literal))
+        return body.encode('latin-1').decode('unicode_escape').encode('latin-1')
+    sys.exit('%s not found under %s' % (name, src))
+
+
+def load_art(path):
+    """The text and digit fonts of a glyph file, in u8x8 font layout."""
+    glyphs = {'text': {}, 'digit': {}}
+    rows = None
+    for line in open(path):
+        line = line.rstrip('\n')
+        m = re.match(r"^(text|digit) '(.)'$", line)
+        if m:
+            rows = glyphs[m.group(1)][m.group(2)] = []
+        elif line and not line.startswith('#'):
+            rows.append(line)
+    return u8x8_font(glyphs['text'], 1, 1), u8x8_font(glyphs['digit'], 2, 3)
+
+
+def u8x8_font(glyphs, tw, th):
+    first, last = min(map(ord, glyphs)), max(map(ord, glyphs))
+    font = bytearray([first, last, tw, th])
+    for code in range(first, last + 1):
+        rows = glyphs.get(chr(code), ['.' * tw * 8] * th * 8)
+        if len(rows) != th * 8 or any(len(r) != tw * 8 for r in rows):
+            sys.exit('glyph %r is not %dx%d' % (chr(code), tw * 8, th * 8))
+        for ty in range(th):
+            for tx in range(tw):
+                for x in range(8):
+                    font.append(sum(1 << i for i in range(8)
+                                    if rows[ty * 8 + i][tx * 8 + x] == '#'))
+    return bytes(font)
+
+
+def tiles(font, c):
+    first, last, tw, th = font[0], font[1], font[2], font[3]
+    code = ord(c)
+    if not first <= code <= last:
+        sys.exit('%r is not in the font' % c)
+    n = tw * th
+    at = 4 + (code - first) * n * 8
+    return [font[at + i * 8:at + i * 8 + 8] for i in range(n)]
+
+
+def stretch(nibble):
+    b = 0
+    for i in range(4):
+        if nibble & (1 << i):
+            b |= 3 << (i * 2)
+    return b
+
+
+def tall(tile):
+    return bytes(stretch(b & 15) for b in tile) + bytes(stretch(b >> 4) for b in tile)
+
+
+def table(name, data, per_line=16):
+    rows = ['  ' + ', '.join('0x%02x' % b for b in data[i:i + per_line]) + ','
+            for i in range(0, len(data), per_line)]
+    return 'const uint8_t %s[] PROGMEM = {\n%s\n};\n' % (name, '\n'.join(rows))
+
+
+def glyph_map(chars):
+    m = [0xff] * MAP_SIZE
+    for slot, c in enumerate(chars):
+        m[ord(c) - MAP_FIRST] = slot
+    return bytes(m)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('source', help='tools/glyphs.txt or the src directory of U8g2')
+    args = ap.parse_args()
+
+    if os.path.isdir(args.source):
+        text_font = load_font(args.source, TEXT_FONT)
+        digit_font = load_font(args.source, DIGIT_FONT)
+        origin = '%s and %s' % (TEXT_FONT, DIGIT_FONT)
+    else:
+        text_font, digit_font = load_art(args.source)
+        origin = 'tools/' + os.path.basename(args.source)
+    text = b''.join(tall(tiles(text_font, c)[0]) for c in TEXT_CHARS)
+    digits = b''.join(b''.join(tiles(digit_font, c)) for c in DIGIT_CHARS)
+    text_map = glyph_map(TEXT_CHARS)
+    digit_map = glyph_map(DIGIT_CHARS)
+
+    after = len(text) + len(digits) + len(text_map) + len(digit_map)
+    print('// Generated by tools/gen_fonts.py from %s, do not edit.' % origin)
+    print('// %d bytes of flash.' % after)
+    print('#ifndef UBITX_FONTS_GEN_H_')
+    print('#define UBITX_FONTS_GEN_H_')
+    print()
+    print('#include <avr/pgmspace.h>')
+    print()
+    print('namespace fonts {')
+    print()
+    print('const unsigned char MAP_FIRST = %d;' % MAP_FIRST)
+    print('const unsigned char MAP_SIZE = %d;' % MAP_SIZE)
+    print('const unsigned char NONE = 0xff;')
+    print()
+    print('// %s: glyph - MAP_FIRST to slot, 16 bytes per slot, top tile first' % TEXT_CHARS)
+    print(table('TEXT_MAP', text_map), end='')
+    print(table('TEXT', text), end='')
+    print()
+    print('// %s: glyph - MAP_FIRST to slot, 48 bytes per slot, tiles row by row' % DIGIT_CHARS)
+    print(table('DIGIT_MAP', digit_map), end='')
+    print(table('DIGIT', digits), end='')
+    print()
+    print('}  // namespace')
+    print()
+    print('#endif  // UBITX_FONTS_GEN_H_')
+    if os.path.isdir(args.source):
+        before = len(text_font) + len(digit_font)
+        sys.stderr.write('fonts: %d bytes, the u8x8 fonts %d, %d saved\n'
+                         % (after, before, before - after))
+    else:
+        sys.stderr.write('fonts: %d bytes\n' % after)
+
+
+if __name__ == '__main__':
+    main()
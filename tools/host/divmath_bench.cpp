@@ -0,0 +1,184 @@
+/**
+ * Checks the msynth parameters SetFreq() computes with the divider cache
+ * (DivMod) and the shift and subtract fraction (EncodeMs) against the
+ * straight long division formula they replaced, byte for byte, and
+ * compares their speed and the number of 32 bit long divisions per call.
+ *
+ * The old formula is done in uint32_t as on the AVR. Host times only
+ * show the relative cost: x86 divides in hardware, the ATmega328P calls
+ * __udivmodsi4 at several hundred cycles per division, so on the radio
+ * the division count is what matters.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include "host.h"
+
+namespace si5351 {
+
+// si5351.cpp internals, not in its header
+struct DivCache {
+  unsigned long num;
+  unsigned long den;
+  unsigned long quot;
+  unsigned long rem;
+};
+DivCache *CacheFor(unsigned long fout);
+void DivMod(DivCache *c, unsigned long num, unsigned long den);
+void EncodeMs(char *vals, unsigned long a, unsigned long b, unsigned long c);
+
+}  // namespace
+
+namespace {
+
+const unsigned long FIRST_IF = 45005000;
+const unsigned long CARRIER = 11056586;
+const long CALS[] = {-300000, 0, 161000, 300000};  // vcoa = 875 MHz + cal
+
+#define BB0(x) ((char)(x))
+#define BB1(x) ((char)((x) >> 8))
+#define BB2(x) ((char)((x) >> 16))
+
+// SetFreq() before the divider cache, rdiv 0
+void OldMs(char *vals, uint32_t vcoa, uint32_t fout) {
+  uint32_t msa, msb, msc, msxp1, msxp2, msxp3p2top;
+  msa = vcoa / fout;
+  msb = vcoa % fout;
+  msc = fout;
+  while (msc & 0xfff00000) {
+    msb = msb >> 1;
+    msc = msc >> 1;
+  }
+  msxp1 = 128 * msa + 128 * msb / msc - 512;
+  msxp2 = 128 * msb - 128 * msb / msc * msc;
+  msxp3p2top = ((msc & 0x0F0000) << 4) | msxp2;
+  vals[0] = BB1(msc);
+  vals[1] = BB0(msc);
+  vals[2] = BB2(msxp1);
+  vals[3] = BB1(msxp1);
+  vals[4] = BB0(msxp1);
+  vals[5] = BB2(msxp3p2top);
+  vals[6] = BB1(msxp2);
+  vals[7] = BB0(msxp2);
+}
+
+// The same test DivMod() makes to pick the correction over a division
+bool Incremental(const si5351::DivCache *c, unsigned long num, unsigned long den) {
+  long dd = den - c->den;
+  if (!c->den || c->quot >= 0x800 || dd <= -0x80000 || dd >= 0x80000) return false;
+  long delta = (long)(num - c->num) - (long)c->quot * dd;
+  return delta > -(long)(den << 2) && delta < (long)(den << 2);
+}
+
+unsigned long divisions;
+
+// SetFreq() now
+void NewMs(char *vals, unsigned long vcoa, unsigned long fout) {
+  si5351::DivCache *c = si5351::CacheFor(fout);
+  if (!Incremental(c, vcoa, fout)) divisions++;
+  si5351::DivMod(c, vcoa, fout);
+  si5351::EncodeMs(vals, c->quot, c->rem, fout);
+}
+
+const unsigned int MAX_CALLS = 20000;
+uint32_t calls[MAX_CALLS];
+unsigned int ncalls;
+
+void Add(uint32_t fout) {
+  if (ncalls < MAX_CALLS) calls[ncalls++] = fout;
+}
+
+// What RefreshImages() asks for, rx then cw tx, per 50 Hz knob step
+void Tuning() {
+  static const uint32_t START[] = {1840000, 3573000, 7074000, 14074000, 28074000};
+  for (unsigned char i = 0; i < 5; i++) {
+    for (unsigned int s = 0; s < 400; s++) {
+      uint32_t f = START[i] + s * 50;
+      Add(CARRIER);
+      Add(FIRST_IF + f);
+      Add(FIRST_IF + CARRIER);
+      Add(f + 800);
+    }
+  }
+}
+
+void Sweep() {
+  for (uint32_t khz = 1000; khz <= 30000; khz += 100) Add(FIRST_IF + khz * 1000);
+}
+
+// Anywhere in the range SetFreq() accepts, each call a cold division
+void Random() {
+  uint32_t x = 12345;
+  for (unsigned int i = 0; i < 10000; i++) {
+    x = x * 1103515245 + 12345;
+    Add(500000 + x % 108500000);
+  }
+}
+
+struct Workload {
+  const char *name;
+  void (*Make)();
+};
+
+const Workload WORKLOADS[] = {
+  {"tuning", Tuning},
+  {"sweep", Sweep},
+  {"random", Random},
+};
+
+}  // namespace
+
+int main() {
+  unsigned long mismatches = 0;
+  printf("%-8s %6s %10s %10s %9s %9s %6s\n", "workload", "calls", "old div",
+         "new div", "old ns", "new ns", "speed");
+  for (const Workload &w : WORKLOADS) {
+    ncalls = 0;
+    w.Make();
+    unsigned long old_divisions = 0, new_divisions = 0, total = 0;
+    uint64_t old_ns = 0, new_ns = 0;
+    for (long cal : CALS) {
+      unsigned long vcoa = 875000000 + cal;
+      char old_vals[8], new_vals[8];
+      for (unsigned int i = 0; i < ncalls; i++) {
+        OldMs(old_vals, vcoa, calls[i]);
+        divisions = 0;
+        NewMs(new_vals, vcoa, calls[i]);
+        new_divisions += divisions;
+        for (unsigned char b = 0; b < 8; b++) {
+          if (old_vals[b] == new_vals[b]) continue;
+          if (!mismatches++)
+            printf("mismatch: vcoa %lu fout %u byte %u: %02x, was %02x\n", vcoa,
+                   calls[i], b, new_vals[b] & 0xff, old_vals[b] & 0xff);
+        }
+      }
+      old_divisions += 2 * ncalls;  // vco / fout and 128 * msb / msc
+      total += ncalls;
+
+      // Timing runs repeat the sequence so the cache sees it as the radio does
+      volatile char sink = 0;
+      uint64_t t = host::Nanos();
+      for (unsigned char r = 0; r < 50; r++)
+        for (unsigned int i = 0; i < ncalls; i++) {
+          OldMs(old_vals, vcoa, calls[i]);
+          sink ^= old_vals[7];
+        }
+      old_ns += host::Nanos() - t;
+      t = host::Nanos();
+      for (unsigned char r = 0; r < 50; r++)
+        for (unsigned int i = 0; i < ncalls; i++) {
+          si5351::DivCache *c = si5351::CacheFor(calls[i]);
+          si5351::DivMod(c, vcoa, calls[i]);
+          si5351::EncodeMs(new_vals, c->quot, c->rem, calls[i]);
+          sink ^= new_vals[7];
+        }
+      new_ns += host::Nanos() - t;
+    }
+    double per_call_old = (double)old_ns / (50.0 * total);
+    double per_call_new = (double)new_ns / (50.0 * total);
+    printf("%-8s %6lu %10.2f %10.2f %9.1f %9.1f %5.2fx\n", w.name, total,
+           (double)old_divisions / total, (double)new_divisions / total,
+           per_call_old, per_call_new, per_call_old / per_call_new);
+  }
+  printf("%lu byte mismatches\n", mismatches);
+  return mismatches ? 1 : 0;
+}
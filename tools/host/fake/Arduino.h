@@ -0,0 +1,49 @@
+// Just enough of the Arduino core for the firmware files the host build
+// compiles
+#ifndef HOST_ARDUINO_H_
+#define HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define DEC 10
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A6 20
+#define A7 21
+
+unsigned long millis();
+unsigned long micros();
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void tone(uint8_t pin, unsigned int hz, unsigned long ms = 0);
+void noTone(uint8_t pin);
+void delay(unsigned long ms);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+char *itoa(int value, char *s, int radix);
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *)(s))
+
+// Output goes nowhere
+struct HardwareSerial {
+  template <typename T> void print(T) {}
+  template <typename T> void println(T) {}
+};
+extern HardwareSerial Serial;
+
+#endif  // HOST_ARDUINO_H_
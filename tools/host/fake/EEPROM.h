@@ -0,0 +1,35 @@
+#ifndef HOST_EEPROM_H_
+#define HOST_EEPROM_H_
+
+#include <string.h>
+#include <type_traits>
+
+// Size of T on the ATmega328P, so the EEPROM layout is the one the radio has
+template <class T> struct AvrSize { enum { N = sizeof(T) }; };
+template <> struct AvrSize<int> { enum { N = 2 }; };
+template <> struct AvrSize<unsigned int> { enum { N = 2 }; };
+template <> struct AvrSize<long> { enum { N = 4 }; };
+template <> struct AvrSize<unsigned long> { enum { N = 4 }; };
+
+// 1 KB like the ATmega328P, starts out erased. Values are kept little
+// endian at their AVR size, wider host integers are truncated on put and
+// extended on get.
+struct EEPROMClass {
+  unsigned char data[1024];
+  EEPROMClass() { memset(data, 0xff, sizeof(data)); }
+  template <class T> T &get(int at, T &t) {
+    const int n = AvrSize<T>::N;
+    bool negative = std::is_signed<T>::value && (data[at + n - 1] & 0x80);
+    memset(&t, negative ? 0xff : 0, sizeof(T));
+    memcpy(&t, data + at, n);
+    return t;
+  }
+  template <class T> const T &put(int at, const T &t) {
+    memcpy(data + at, &t, AvrSize<T>::N);
+    return t;
+  }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif  // HOST_EEPROM_H_
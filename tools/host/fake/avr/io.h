@@ -0,0 +1,24 @@
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+#define _BV(b) (1 << (b))
+
+extern volatile uint8_t PINC;
+extern volatile uint16_t TCNT1;
+extern volatile uint8_t WDTCSR;
+extern volatile uint8_t SREG;
+extern volatile uint8_t ADMUX;
+extern volatile uint8_t ADCSRA;
+extern volatile uint16_t ADC;
+
+#define WDIE 6
+#define REFS0 6
+#define ADSC 6
+#define ADIE 3
+
+#define PC2 2
+#define PC3 3
+
+#endif  // HOST_AVR_IO_H_
@@ -0,0 +1,20 @@
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+// One address space on the host
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) ([](const void *a) { uint16_t w; memcpy(&w, a, 2); return w; }(p))
+#define pgm_read_dword(p) ([](const void *a) { uint32_t d; memcpy(&d, a, 4); return d; }(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strlen_P strlen
+
+#endif  // HOST_AVR_PGMSPACE_H_
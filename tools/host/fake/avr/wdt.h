@@ -0,0 +1,6 @@
+#ifndef HOST_AVR_WDT_H_
+#define HOST_AVR_WDT_H_
+
+inline void wdt_reset() {}
+
+#endif  // HOST_AVR_WDT_H_
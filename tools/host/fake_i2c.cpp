@@ -0,0 +1,122 @@
+// i2c.h on top of models of the Si5351 register file and the SSD1306
+// display RAM, traffic is counted the same way the interrupt driven queue
+// counts it
+#include "i2c.h"
+#include <stdio.h>
+#include <string.h>
+#include "host.h"
+#include "si5351.h"
+
+namespace i2c {
+
+unsigned int errors = 0;
+unsigned long bytes[2];
+unsigned int transactions[2];
+
+unsigned char open_addr, open_prio, open_len;
+unsigned char open_data[256];
+
+void Init() {}
+void SetClock(unsigned char addr, unsigned long hz) {}
+
+void Begin(unsigned char addr, unsigned char prio) {
+  open_addr = addr;
+  open_prio = prio;
+  open_len = 0;
+}
+
+void Write(unsigned char b) {
+  open_data[open_len++] = b;
+}
+
+// Control byte 0x00: commands to the end, 0x80: one command and another
+// control byte, 0x40: display data to the end
+void Ssd1306(const unsigned char *b, unsigned char len) {
+  static unsigned char page, column;
+  unsigned char i = 0;
+  while (i < len) {
+    unsigned char control = b[i++];
+    if (control == 0x40) {
+      while (i < len) {
+        host::oled[page][column] = b[i++];
+        column = (column + 1) & 127;
+      }
+      return;
+    }
+    while (i < len) {
+      unsigned char c = b[i++];
+      if (c >= 0xB0 && c <= 0xB7) page = c & 7;
+      else if (c <= 0x0F) column = (column & 0xF0) | c;
+      else if (c >= 0x10 && c <= 0x1F) column = (column & 0x0F) | (c & 7) << 4;
+      else if (strchr("\x20\x81\x8D\xA8\xD3\xD5\xD9\xDA\xDB", c)) i++;  // one argument
+      if (control == 0x80) break;
+    }
+  }
+}
+
+bool End() {
+  if (open_len > (open_prio == PRIO_HIGH ? MAX_HIGH : MAX_LOW)) {
+    host::oversized++;
+    errors++;
+    return false;
+  }
+  bytes[open_prio] += open_len + 1;
+  transactions[open_prio]++;
+  if (open_addr == 0x3C) Ssd1306(open_data, open_len);
+  if (open_addr != 0x60 || !open_len) return true;
+  unsigned char reg = open_data[0];
+  for (unsigned char i = 1; i < open_len; i++) {
+    if (reg == 177) host::pll_resets++;
+    host::si5351_regs[reg++] = open_data[i];
+  }
+  return true;
+}
+
+bool Busy() { return false; }
+bool Sending(unsigned char prio) { return false; }
+unsigned char Free(unsigned char prio) { return prio == PRIO_HIGH ? MAX_HIGH : MAX_LOW; }
+void Flush() {}
+
+}  // namespace
+
+namespace host {
+
+unsigned char si5351_regs[256];
+unsigned char oled[8][128];
+unsigned int pll_resets = 0;
+unsigned int oversized = 0;
+
+const unsigned long MSA = 35;  // PLLA multiplier, as si5351.cpp programs it
+
+typedef unsigned __int128 u128;
+
+// p1, p2, p3 of the 8 msynth registers at r as num / den = a + b / c
+void Multisynth(const unsigned char *r, u128 *num, u128 *den, unsigned char *rdiv) {
+  unsigned long p3 = ((unsigned long)(r[5] >> 4) << 16) | (r[0] << 8) | r[1];
+  unsigned long p1 = ((unsigned long)(r[2] & 3) << 16) | (r[3] << 8) | r[4];
+  unsigned long p2 = ((unsigned long)(r[5] & 15) << 16) | (r[6] << 8) | r[7];
+  *num = (u128)(p1 + 512) * p3 + p2;  // 128 times the divider
+  *den = (u128)p3 * 128;
+  *rdiv = 1 << ((r[2] >> 4) & 7);
+}
+
+// Like tools/synth_check.py: the crystal is taken to be the calibrated
+// si5351bx_vcoa / MSA, so a correct setting decodes to the wanted frequency.
+void FormatClock(unsigned char n, char *buf) {
+  const unsigned char *r = si5351_regs;
+  if ((r[3] & (1 << n)) || (r[16 + n] & 0x80)) {
+    sprintf(buf, "off");
+    return;
+  }
+  u128 pll_num, pll_den, ms_num, ms_den;
+  unsigned char rdiv;
+  Multisynth(r + ((r[16 + n] & 0x20) ? 34 : 26), &pll_num, &pll_den, &rdiv);
+  Multisynth(r + 42 + n * 8, &ms_num, &ms_den, &rdiv);
+  u128 num = (u128)si5351::si5351bx_vcoa * pll_num * ms_den * 1000;
+  u128 den = pll_den * ms_num * rdiv * MSA;
+  uint64_t mhz = (uint64_t)((num + den / 2) / den);
+  sprintf(buf, "%llu.%03llu", (unsigned long long)(mhz / 1000),
+          (unsigned long long)(mhz % 1000));
+}
+
+}  // namespace
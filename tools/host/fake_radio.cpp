@@ -0,0 +1,71 @@
+// The Arduino core and the modules ubitx.cpp calls into, reduced to what
+// a run on a PC needs
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <stdio.h>
+#include <time.h>
+#include "host.h"
+#include "cat.h"
+#include "keyer.h"
+#include "power.h"
+#include "watchdog.h"
+
+EEPROMClass EEPROM;
+volatile uint8_t PINC = 0xff;  // buttons up
+volatile uint16_t TCNT1 = 0;
+volatile uint8_t WDTCSR = 0;
+volatile uint8_t SREG = 0;
+volatile uint8_t ADMUX = 0;
+volatile uint8_t ADCSRA = 0;
+volatile uint16_t ADC = 0;
+HardwareSerial Serial;
+
+namespace host {
+
+unsigned char pins[32];
+unsigned long now_ms = 0;
+
+uint64_t Nanos() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+}  // namespace
+
+unsigned long millis() { return host::now_ms; }
+unsigned long micros() { return host::now_ms * 1000; }
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t value) { host::pins[pin & 31] = value; }
+int digitalRead(uint8_t pin) { return host::pins[pin & 31]; }
+int analogRead(uint8_t pin) { return 0; }
+void tone(uint8_t pin, unsigned int hz, unsigned long ms) {}
+void noTone(uint8_t pin) {}
+void delay(unsigned long ms) { host::now_ms += ms; }
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+char *itoa(int value, char *s, int radix) {
+  sprintf(s, "%d", value);
+  return s;
+}
+
+namespace cat {
+void Changed(unsigned char what) {}
+}  // namespace
+
+namespace keyer {
+char keyer_control = 0;
+unsigned long cw_timeout = 0;
+}  // namespace
+
+namespace power {
+volatile bool activity = false;
+void Wake() {}
+}  // namespace
+
+namespace watchdog {
+void Disable() {}
+}  // namespace
@@ -0,0 +1,18 @@
+// The display and the swr meter for the synthesizer scenarios, which only
+// look at the Si5351. ui_test links the real ones.
+#include <avr/pgmspace.h>
+#include "swr.h"
+#include "ui.h"
+
+namespace swr {
+void Start() {}
+void Stop() {}
+}  // namespace
+
+namespace ui {
+void Clear() {}
+void Flush() {}
+void ReleaseGraph() {}
+void PrintLine_P(unsigned char line_nr, PGM_P c) {}
+void Changed(unsigned char what) {}
+}  // namespace
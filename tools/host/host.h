@@ -0,0 +1,32 @@
+#ifndef HOST_HOST_H_
+#define HOST_HOST_H_
+
+#include <stdint.h>
+
+namespace host {
+
+/**
+ * The Si5351 as the fake i2c bus leaves it: a register file written the
+ * way the chip takes a write transaction (register pointer, then data
+ * with auto increment), and the output frequencies it derives from it.
+ */
+extern unsigned char si5351_regs[256];
+extern unsigned int pll_resets;      // writes to register 177
+extern unsigned int oversized;       // transactions longer than the queue takes
+
+void FormatClock(unsigned char n, char *buf);  // "off" or Hz with 3 decimals
+
+/**
+ * The SSD1306 the same way: the display RAM by page and column, written
+ * through the page addressing commands and data bursts ui.cpp sends.
+ */
+extern unsigned char oled[8][128];
+
+extern unsigned char pins[32];       // last digitalWrite() per pin
+extern unsigned long now_ms;         // what millis() returns
+
+uint64_t Nanos();
+
+}  // namespace
+
+#endif  // HOST_HOST_H_
@@ -0,0 +1,282 @@
+/**
+ * Runs si5351.cpp and ubitx.cpp on a PC against the fake i2c bus and
+ * prints, after every step, the three output frequencies the Si5351
+ * register file decodes to and the i2c bytes and transactions the step
+ * cost. The CSV on stdout is compared with golden.csv by `make check`, a
+ * per scenario cost summary goes to stderr.
+ *
+ * The same columns as tools/synth_check.py, which reads the registers
+ * from a real radio over CAT, plus the RIT and CW transmit steps that
+ * have no CAT command.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <EEPROM.h>
+#include "host.h"
+#include "eeprom.h"
+#include "i2c.h"
+#include "si5351.h"
+#include "swr.h"
+#include "ubitx.h"
+
+namespace {
+
+// 400 kHz bus, 9 bit times per byte and about 2 for start and stop
+const double BUS_US_PER_BYTE = 9 * 2.5;
+const double BUS_US_PER_TRANSACTION = 2 * 2.5;
+
+struct Cost {
+  const char *scenario;
+  unsigned int steps;
+  unsigned long bytes;
+  unsigned long transactions;
+  uint64_t ns;
+};
+
+Cost costs[24];
+unsigned char scenarios = 0;
+unsigned long last_bytes = 0, last_transactions = 0;
+uint64_t step_start;
+
+void Begin() {
+  step_start = host::Nanos();
+}
+
+// Closes the step opened by Begin() with the dispatch the scheduler runs
+// after every task, then prints its row
+void Step(const char *scenario) {
+  ubitx::DispatchChanges();
+  uint64_t ns = host::Nanos() - step_start;
+  unsigned long b = i2c::bytes[i2c::PRIO_HIGH] - last_bytes;
+  unsigned long t = i2c::transactions[i2c::PRIO_HIGH] - last_transactions;
+  last_bytes = i2c::bytes[i2c::PRIO_HIGH];
+  last_transactions = i2c::transactions[i2c::PRIO_HIGH];
+
+  char clk[3][24];
+  for (unsigned char n = 0; n < 3; n++) host::FormatClock(n, clk[n]);
+  printf("%s,%lu,%s,%s,%s,%s,%s,%lu,%lu\n", scenario, ubitx::frequency,
+         ubitx::status.is_usb ? "usb" : "lsb", ubitx::in_tx ? "tx" : "rx",
+         clk[0], clk[1], clk[2], b, t);
+
+  Cost *c = costs;
+  while (c < costs + scenarios && strcmp(c->scenario, scenario)) c++;
+  if (c == costs + scenarios) {
+    if (scenarios == sizeof(costs) / sizeof(costs[0])) return;
+    c->scenario = scenario;
+    scenarios++;
+  }
+  c->steps++;
+  c->bytes += b;
+  c->transactions += t;
+  c->ns += ns;
+}
+
+// The EEPROM defaults of ResetSettingsAndHalt()
+void Boot() {
+  EEPROM.put(eeprom::MASTER_CAL, 161000l);
+  EEPROM.put(eeprom::USB_CARRIER, 11056586ul);
+  EEPROM.put(eeprom::CW_SIDE_TONE, 800u);
+  EEPROM.put(eeprom::VFO_A, 3573000ul);
+  EEPROM.put(eeprom::VFO_B, 7074000ul);
+  EEPROM.put(eeprom::CW_SPEED, 100);
+  EEPROM.put(eeprom::VFO_A_USB, true);
+  EEPROM.put(eeprom::VFO_B_USB, true);
+  EEPROM.put(eeprom::IAMBIC_KEY, (unsigned char)1);
+  EEPROM.put(eeprom::CW_DELAY_TIME, 60);
+  EEPROM.put(eeprom::SWR_LIMIT, swr::LIMIT_DEFAULT);
+  EEPROM.put(eeprom::MAGIC_ADDR, (char)eeprom::MAGIC_NR);
+
+  Begin();
+  ubitx::InitPorts();
+  ubitx::InitSettings();
+  ubitx::InitOscillators();
+  ubitx::SetFrequency(ubitx::settings.vfo_a);
+  ubitx::SidebandSet(ubitx::settings.vfo_a_usb);
+  Step("boot");
+}
+
+void Sweep() {
+  for (unsigned long khz = 1000; khz <= 30000; khz += 100) {
+    Begin();
+    ubitx::SetFrequency(khz * 1000);
+    Step("sweep");
+  }
+}
+
+// Encoder steps, the common case
+void Tune() {
+  static const unsigned long START[] = {3573000, 7074000, 14074000, 28074000};
+  for (unsigned char i = 0; i < 4; i++) {
+    for (unsigned char s = 0; s < 20; s++) {
+      Begin();
+      ubitx::SetFrequency(START[i] + s * 50ul);
+      Step("tune");
+    }
+  }
+}
+
+void Mode() {
+  static const unsigned long DIAL[] = {1840000, 3573000, 7074000, 14074000, 28074000};
+  for (unsigned char i = 0; i < 5; i++) {
+    Begin();
+    ubitx::SetFrequency(DIAL[i]);
+    Step("mode");
+    for (unsigned char usb = 0; usb < 3; usb++) {
+      Begin();
+      ubitx::SidebandSet(usb == 1);
+      Step("mode");
+    }
+  }
+}
+
+void Split() {
+  Begin();
+  ubitx::SetFrequency(7030000);
+  ubitx::VfoSwap(true);
+  ubitx::SetFrequency(7040000);
+  ubitx::SplitEnable();
+  Step("split");
+  Begin();
+  ubitx::TxStartSsb();
+  Step("split-tx");
+  Begin();
+  ubitx::TxStop();
+  Step("split-rx");
+  Begin();
+  ubitx::TxStartCw();
+  Step("split-cw");
+  Begin();
+  ubitx::TxStop();
+  Step("split-rx");
+  Begin();
+  ubitx::SplitDisable();
+  ubitx::VfoSwap(true);
+  Step("split-off");
+}
+
+// The receiver moves off the dial, tx stays where RIT was switched on
+void Rit() {
+  Begin();
+  ubitx::SetFrequency(14074000);
+  ubitx::RitEnable(14074000);
+  Step("rit");
+  for (unsigned char s = 1; s <= 10; s++) {
+    Begin();
+    ubitx::SetFrequency(14074000 + s * 50ul);
+    Step("rit");
+  }
+  Begin();
+  ubitx::TxStartSsb();
+  Step("rit-tx");
+  Begin();
+  ubitx::TxStop();
+  Step("rit-rx");
+  Begin();
+  ubitx::TxStartCw();
+  Step("rit-cw");
+  Begin();
+  ubitx::TxStop();
+  Step("rit-rx");
+  Begin();
+  ubitx::RitDisable();
+  Step("rit-off");
+}
+
+// The keyer holds the radio in tx while keying, a call is one key down
+void Cw() {
+  static const unsigned long DIAL[] = {3530000, 7030000, 14030000};
+  for (unsigned char i = 0; i < 3; i++) {
+    for (unsigned char usb = 0; usb < 2; usb++) {
+      Begin();
+      ubitx::SetFrequency(DIAL[i]);
+      ubitx::SidebandSet(usb);
+      Step("cw");
+      Begin();
+      ubitx::TxStartCw();
+      Step("cw-tx");
+      Begin();
+      ubitx::TxStop();
+      Step("cw-rx");
+    }
+  }
+}
+
+void Ssb() {
+  static const unsigned long DIAL[] = {3573000, 14074000};
+  for (unsigned char i = 0; i < 2; i++) {
+    Begin();
+    ubitx::SetFrequency(DIAL[i]);
+    Step("ssb");
+    Begin();
+    ubitx::TxStartSsb();
+    Step("ssb-tx");
+    Begin();
+    ubitx::TxStop();
+    Step("ssb-rx");
+  }
+}
+
+/**
+ * The first oscillator stepped 50 Hz at a time both ways SetVfo() can
+ * tune it: the fractional output msynth (SetFreq, the default) and PLLB
+ * behind an integer output divider (SetFreqPll, VFO_PLL_TUNING). The
+ * radio build uses one of them, this keeps both covered.
+ */
+void VfoPaths() {
+  static const unsigned long DIAL[] = {3573000, 7074000, 14074000, 28074000};
+  for (unsigned char pll = 0; pll < 2; pll++) {
+    for (unsigned char i = 0; i < 4; i++) {
+      for (unsigned char s = 0; s < 20; s++) {
+        unsigned long f = 45005000 + DIAL[i] + s * 50ul;
+        Begin();
+        if (pll)
+          si5351::SetFreqPll(2, f);
+        else
+          si5351::SetFreq(2, f);
+        Step(pll ? "vfo-pll" : "vfo-ms");
+      }
+    }
+  }
+  Begin();
+  ubitx::RestoreDial();
+  Step("restore");
+}
+
+void Report() {
+  unsigned int steps = 0;
+  unsigned long bytes = 0, transactions = 0;
+  fprintf(stderr, "%-10s %5s %8s %8s %8s %8s\n", "scenario", "steps",
+          "bytes", "trans", "bus us", "host ns");
+  for (unsigned char i = 0; i < scenarios; i++) {
+    const Cost &c = costs[i];
+    double n = c.steps;
+    fprintf(stderr, "%-10s %5u %8.2f %8.2f %8.1f %8.0f\n", c.scenario, c.steps,
+            c.bytes / n, c.transactions / n,
+            (c.bytes * BUS_US_PER_BYTE + c.transactions * BUS_US_PER_TRANSACTION) / n,
+            c.ns / n);
+    steps += c.steps;
+    bytes += c.bytes;
+    transactions += c.transactions;
+  }
+  fprintf(stderr, "%u steps, %.2f bytes and %.2f transactions per step, "
+          "%u PLL resets, %u oversized transactions\n", steps,
+          (double)bytes / steps, (double)transactions / steps,
+          host::pll_resets, host::oversized);
+}
+
+}  // namespace
+
+int main() {
+  printf("scenario,dial,mode,state,clk0,clk1,clk2,bytes,transactions\n");
+  Boot();
+  Sweep();
+  Tune();
+  Mode();
+  Split();
+  Rit();
+  Cw();
+  Ssb();
+  VfoPaths();
+  Report();
+  return host::oversized ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * Runs ui.cpp and swr.cpp against the SSD1306 model of the fake i2c bus:
+ * the tuning screen, the transmit meter, the tuning screen redrawn while
+ * transmitting and the tuning screen after transmit. Checks that the
+ * redraw in tx leaves the power bar and the SWR reading alone and that
+ * the meter rows are free for text again after tx.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <EEPROM.h>
+#include "host.h"
+#include "eeprom.h"
+#include "swr.h"
+#include "ubitx.h"
+#include "ui.h"
+
+namespace mainloop {
+void (*DoActiveApp)();
+void DoTuning() {}
+}  // namespace
+
+namespace menu {
+void DoMenu() {}
+}  // namespace
+
+namespace scope {
+void DoScope() {}
+}  // namespace
+
+namespace swr {
+extern volatile int forward_max;
+extern volatile int reflected_at_max;
+}  // namespace
+
+namespace ui {
+extern unsigned char graph_top;
+}  // namespace
+
+namespace {
+
+unsigned char meter[8][128];
+unsigned int failures = 0;
+
+void Check(bool ok, const char *what) {
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) failures++;
+}
+
+bool PagesEqual(unsigned char first, unsigned char last) {
+  return !memcmp(host::oled[first], meter[first], (last - first + 1) * 128);
+}
+
+bool PagesBlank(unsigned char first, unsigned char last) {
+  for (unsigned char p = first; p <= last; p++)
+    for (unsigned char x = 0; x < 128; x++)
+      if (host::oled[p][x]) return false;
+  return true;
+}
+
+// The redraws the display task does, all of them sent
+void Redraw() {
+  ui::UpdateDisplay();
+  ui::Flush();
+}
+
+void Boot() {
+  EEPROM.put(eeprom::USB_CARRIER, 11056586ul);
+  EEPROM.put(eeprom::VFO_A, 14074000ul);
+  EEPROM.put(eeprom::VFO_A_USB, true);
+  EEPROM.put(eeprom::SWR_LIMIT, swr::LIMIT_DEFAULT);
+  EEPROM.put(eeprom::MAGIC_ADDR, (char)eeprom::MAGIC_NR);
+  ui::Init();
+  ubitx::InitPorts();
+  ubitx::InitSettings();
+  ubitx::InitOscillators();
+  ubitx::SetFrequency(ubitx::settings.vfo_a);
+  ubitx::SidebandSet(ubitx::settings.vfo_a_usb);
+  mainloop::DoActiveApp = mainloop::DoTuning;
+}
+
+}  // namespace
+
+int main() {
+  Boot();
+  Redraw();
+  Check(ui::graph_top == ui::ROWS, "rx: no graph rows claimed");
+
+  ubitx::TxStartSsb();
+  Redraw();
+  swr::forward_max = 700;             // 59 columns of bar, the peak on the 60th
+  swr::reflected_at_max = 100;
+  swr::Draw();
+  ui::Flush();
+  memcpy(meter, host::oled, sizeof(meter));
+  Check(host::oled[7][0] == 0xff && host::oled[7][58] == 0xff && host::oled[7][60] != 0xff,
+        "tx: power bar from column 0");
+  Check(!PagesBlank(1, 2), "tx: SWR reading shown");
+
+  Redraw();
+  Check(PagesEqual(6, 7), "tx redraw: power bar kept, column 0 included");
+  Check(PagesEqual(1, 2), "tx redraw: SWR reading kept");
+
+  ubitx::TxStop();
+  Check(ui::graph_top == ui::ROWS, "rx again: graph rows given back");
+  Redraw();
+  Check(PagesBlank(6, 7), "rx again: meter rows cleared");
+  ui::DrawBar(0, 16);
+  ui::Flush();
+  Check(PagesBlank(6, 7), "rx again: bars are not drawn");
+
+  return failures ? 1 : 0;
+}
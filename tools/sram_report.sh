@@ -0,0 +1,49 @@
+#!/bin/sh
+# SRAM used per module: .data + .bss of every object of the sketch, then
+# the libraries and the core as a whole, and the biggest RAM symbols of
+# the linked firmware. The stack gets whatever is left of the 2048 bytes.
+# Object sizes are before the linker drops unused data, so the total can
+# be a little high, the symbol list is exact.
+#
+#   arduino-cli compile -b arduino:avr:nano --build-path /tmp/ubitx-build
+#   tools/sram_report.sh /tmp/ubitx-build
+#
+# Needs avr-size and avr-nm from the AVR toolchain on the PATH.
+
+set -e
+BUILD=${1:?usage: $0 build-path}
+TOP=${TOP:-15}
+RAM=2048
+
+module_ram() {
+  # berkeley format: text data bss dec hex filename
+  avr-size "$@" | awk 'NR > 1 { ram += $2 + $3 } END { print ram + 0 }'
+}
+
+echo "module          data+bss"
+total=0
+for o in "$BUILD"/sketch/*.cpp.o; do
+  [ -e "$o" ] || continue
+  name=$(basename "$o" .cpp.o)
+  n=$(module_ram "$o")
+  total=$((total + n))
+  printf '%-16s %6d\n' "$name" "$n"
+done
+for part in libraries core; do
+  objs=$(find "$BUILD/$part" -name '*.o' 2>/dev/null)
+  [ -n "$objs" ] || continue
+  # shellcheck disable=SC2086
+  n=$(module_ram $objs)
+  total=$((total + n))
+  printf '%-16s %6d\n' "($part)" "$n"
+done
+printf '%-16s %6d of %d, %d left for the stack\n' total "$total" "$RAM" $((RAM - total))
+
+elf=$(ls "$BUILD"/*.ino.elf 2>/dev/null | head -n 1)
+if [ -n "$elf" ]; then
+  echo
+  echo "largest RAM symbols"
+  avr-nm -C -S --size-sort --radix=d "$elf" |
+    awk '$3 ~ /^[bBdD]$/ { printf "%6d %s\n", $2, substr($0, index($0, $4)) }' |
+    sort -rn | head -n "$TOP"
+fi
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""Drive the radio over CAT and record what the Si5351 was programmed with.
+
+After every step the radio is asked for its Si5351 registers (vendor CAT
+opcode 0xDE). They are decoded back into the three output frequencies the
+same way the chip derives them, together with the i2c bytes and
+transactions the step cost. The result is a CSV of golden vectors; run
+again with --golden to compare a new firmware against it.
+
+    tools/synth_check.py /dev/ttyUSB0 > golden.csv
+    tools/synth_check.py /dev/ttyUSB0 --golden golden.csv
+
+RIT and CW keying have no CAT command and are not covered. --tx adds SSB
+PTT steps, so only use it into a dummy load.
+
+This is an extra for checking a radio. The golden vectors the firmware
+is kept to come from the host build in tools/host (make check), which
+also covers RIT and CW.
+"""
+import argparse
+import csv
+import struct
+import sys
+import time
+from fractions import Fraction
+
+import serial  # pyserial
+
+# Image (38 bytes) + si5351bx_vcoa + i2c bytes + i2c transactions, AVR layout
+SYNTH = struct.Struct('<B3s24s8sHLLH')
+MSA = 35
+FIELDS = ['scenario', 'dial', 'mode', 'clk0', 'clk1', 'clk2', 'bytes', 'transactions']
+
+
+class Radio:
+  def __init__(self, port):
+    self.port = serial.Serial(port, 38400, timeout=2)
+    time.sleep(2)  # the Arduino resets when the port opens
+    self.port.reset_input_buffer()
+    self.last_bytes = self.last_transactions = None
+
+  def cmd(self, p, op, reply):
+    self.port.write(bytes(p) + bytes([op]))
+    data = self.port.read(reply)
+    if len(data) != reply:
+      sys.exit('no CAT reply to opcode 0x%02x' % op)
+    return data
+
+  def set_freq(self, hz):
+    d = '%08d' % (hz // 10)
+    self.cmd([int(d[i:i + 2], 16) for i in range(0, 8, 2)], 0x01, 1)
+
+  def set_mode(self, usb):
+    self.cmd([1 if usb else 0, 0, 0, 0], 0x07, 1)
+
+  def synth(self):
+    (clken, ctrl, ms, pllb, _, vcoa, nbytes, ntrans) = SYNTH.unpack(
+        self.cmd([0, 0, 0, 0], 0xDE, SYNTH.size))
+    clocks = [Decode(clken, ctrl, ms, pllb, vcoa, n) for n in range(3)]
+    if self.last_bytes is None:
+      self.last_bytes, self.last_transactions = nbytes, ntrans
+    cost = ((nbytes - self.last_bytes) & 0xffffffff,
+            (ntrans - self.last_transactions) & 0xffff)
+    self.last_bytes, self.last_transactions = nbytes, ntrans
+    return clocks, cost
+
+
+def Multisynth(r):
+  """a + b / c of 8 msynth registers, and the R divider."""
+  p3 = ((r[5] >> 4) << 16) | (r[0] << 8) | r[1]
+  p1 = ((r[2] & 3) << 16) | (r[3] << 8) | r[4]
+  p2 = ((r[5] & 15) << 16) | (r[6] << 8) | r[7]
+  return (p1 + 512 + Fraction(p2, p3)) / 128, 1 << ((r[2] >> 4) & 7)
+
+
+def Decode(clken, ctrl, ms, pllb, vcoa, n):
+  if clken & (1 << n) or ctrl[n] & 0x80:
+    return None
+  vco = Fraction(vcoa)
+  if ctrl[n] & 0x20:  # PLLB
+    vco = Fraction(vcoa, MSA) * Multisynth(pllb)[0]
+  div, rdiv = Multisynth(ms[n * 8:n * 8 + 8])
+  return vco / div / rdiv
+
+
+def Hz(f):
+  return 'off' if f is None else '%.3f' % float(f)
+
+
+def Scenarios(radio, args):
+  yield 'sweep', None
+  for khz in range(1000, 30001, args.step):
+    radio.set_freq(khz * 1000)
+    yield 'sweep', khz * 1000
+  for hz in (1840000, 3573000, 7074000, 14074000, 28074000):
+    radio.set_freq(hz)
+    for usb in (False, True, False):
+      radio.set_mode(usb)
+      yield 'mode', hz
+  radio.set_freq(7030000)
+  radio.cmd([0, 0, 0, 0], 0x81, 1)  # VFO A/B
+  radio.set_freq(7040000)
+  radio.cmd([0, 0, 0, 0], 0x02, 0)  # split on
+  yield 'split', 7040000
+  if args.tx:
+    radio.cmd([0, 0, 0, 0], 0x08, 1)
+    yield 'split-tx', 7040000
+    radio.cmd([0, 0, 0, 0], 0x88, 1)
+    yield 'split-rx', 7040000
+  radio.cmd([0, 0, 0, 0], 0x82, 0)  # split off
+  radio.cmd([0, 0, 0, 0], 0x81, 1)
+  yield 'split-off', 7030000
+  if args.tx:
+    for hz in (3573000, 14074000):
+      radio.set_freq(hz)
+      radio.cmd([0, 0, 0, 0], 0x08, 1)
+      yield 'tx', hz
+      radio.cmd([0, 0, 0, 0], 0x88, 1)
+      yield 'rx', hz
+
+
+def main():
+  ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+  ap.add_argument('port')
+  ap.add_argument('--step', type=int, default=100, help='sweep step in kHz')
+  ap.add_argument('--tx', action='store_true', help='include SSB PTT steps')
+  ap.add_argument('--golden', help='CSV of a previous run to compare with')
+  args = ap.parse_args()
+
+  radio = Radio(args.port)
+  rows = []
+  out = csv.DictWriter(sys.stdout, FIELDS)
+  out.writeheader()
+  for scenario, dial in Scenarios(radio, args):
+    clocks, cost = radio.synth()
+    if dial is None:
+      continue  # only primes the byte counters
+    row = dict(zip(FIELDS, [scenario, dial, radio.cmd([0, 0, 0, 0], 0x03, 5)[4],
+                            *map(Hz, clocks), *cost]))
+    rows.append(row)
+    out.writerow(row)
+
+  total_bytes = sum(r['bytes'] for r in rows)
+  total_trans = sum(r['transactions'] for r in rows)
+  print('%d steps, %.2f bytes and %.2f transactions per step' %
+        (len(rows), total_bytes / len(rows), total_trans / len(rows)), file=sys.stderr)
+  if not args.golden:
+    return
+  with open(args.golden) as f:
+    golden = list(csv.DictReader(f))
+  bad = 0
+  for g, r in zip(golden, rows):
+    for k in ('clk0', 'clk1', 'clk2'):
+      if g[k] != r[k]:
+        bad += 1
+        print('%s %s %s: %s, was %s' % (r['scenario'], r['dial'], k, r[k], g[k]),
+              file=sys.stderr)
+  g_bytes = sum(int(g['bytes']) for g in golden)
+  print('%d frequency mismatches, bytes %d (golden %d)' % (bad, total_bytes, g_bytes),
+        file=sys.stderr)
+  sys.exit(1 if bad or len(golden) != len(rows) else 0)
+
+
+if __name__ == '__main__':
+  main()
@@ -27,20 +27,24 @@
  *  from www.silabs.com although, strictly speaking it is not a requirment to understand this code. 
  *  Instead, you can look up the Si5351 library written by xxx, yyy. You can download and 
  *  install it from www.url.com to complile this file.
- *  The Wire.h library is used to talk to the Si5351 and we also declare an instance of 
- *  Si5351 object to control the clocks.
+ *  The interrupt driven i2c module is used to talk to the Si5351, shared with the
+ *  OLED display.
  */
 #include "ubitx.h"
 #include <Arduino.h>
 #include <EEPROM.h>
-#include <Wire.h>
 #include "eeprom.h"
 #include "hw.h"
+#include "cat.h"
 #include "keyer.h"
 #include "mainloop.h"
 #include "menu.h"
+#include "perf.h"
+#include "power.h"
 #include "si5351.h"
+#include "swr.h"
 #include "ui.h"
+#include "watchdog.h"
 
 namespace ubitx {
 
@@ -62,9 +66,24 @@ Status status;
 Settings settings;
 
 
+const BandList BAND_LIST[BANDS] PROGMEM = {
+  {"160M",  1810,  2000},
+  {" 80M",  3500,  3800},
+  {" 60M",  5351,  5367},
+  {" 40M",  7000,  7200},
+  {" 30M", 10100, 10150},
+  {" 20M", 14000, 14350},
+  {" 17M", 18068, 18168},
+  {" 15M", 21000, 21450},
+  {" 12M", 24890, 24990},
+  {"  CB", 26953, 27417},
+  {" 10M", 28000, 29700},
+  {"    ",     0, 30000}
+};
 unsigned char active_band;
 // TODO: can we live with only one RIT variable?
 unsigned long frequency;
+bcd::Number frequency_bcd;
 unsigned long rit_rx_frequency;
 unsigned long rit_tx_frequency;  //frequency is the current frequency on the dial
 
@@ -72,6 +91,19 @@ unsigned long rit_tx_frequency;  //frequency is the current frequency on the dia
  * Raduino needs to keep track of current state of the transceiver. These are a few variables that do it
  */
 char in_tx = 0;  //it is set to 1 if in transmit mode (whatever the reason : cw, ptt or cat)
+bool tx_cw = false;  // transmitting with the cw image
+
+/**
+ * Ready made oscillator settings for receive and both kinds of transmit.
+ * They are recomputed in the background after anything they depend on
+ * changes, so a T/R switch only has to send the bytes that differ.
+ */
+si5351::Image rx_image;
+si5351::Image tx_ssb_image;
+si5351::Image tx_cw_image;
+bool images_stale = true;
+
+unsigned char changed = 0;  // CHANGED_ bits not dispatched yet
 
 /**
  * Below are the basic functions that control the uBitx. Understanding the functions before 
@@ -86,6 +118,7 @@ void ActiveDelay(unsigned int delay_by) {
   unsigned long time_start = millis();
 
   while (millis() - time_start <= delay_by) {
+    watchdog::Feed();  // bounded by delay_by
     // Here was CheckCat(), but it's not needed as is now handled
     // with task scheduler.
     // Goal is to refactor all functions calling ActiveDelay
@@ -128,6 +161,131 @@ void SetTxFilters(unsigned long freq) {
   }
 }
 
+/**
+ * The first oscillator (CLK2) is tuned either with its own fractional
+ * msynth or through PLLB, see VFO_PLL_TUNING
+ */
+void SetVfo(unsigned long f) {
+  if (VFO_PLL_TUNING)
+    si5351::SetFreqPll(2, f);
+  else
+    si5351::SetFreq(2, f);
+}
+
+/**
+ * Dial bookkeeping for f: tx filters, frequency and band. The oscillators
+ * are not touched.
+ */
+void SetDial(unsigned long f) {
+  SetTxFilters(f);
+  frequency = f;
+  bcd::FromBinary(f, &frequency_bcd);  // subtractions only, no divisions
+
+  unsigned int khz = frequency / 1000;
+  unsigned char i = 0;
+  for (i = 0; i < BANDS; i++) {
+    if ((khz >= pgm_read_word(&BAND_LIST[i].min_khz)) &&
+        (khz <= pgm_read_word(&BAND_LIST[i].max_khz))) {
+      break;
+    }
+  }
+  active_band = i;
+}
+
+// Oscillators for ssb receive or transmit on f
+void ComposeSsb(unsigned long f, bool usb) {
+  si5351::SetFreq(0, settings.usb_carrier);
+  SetVfo(first_if + f);
+  if (usb)
+    si5351::SetFreq(1, first_if + settings.usb_carrier);
+  else
+    si5351::SetFreq(1, first_if - settings.usb_carrier);
+}
+
+// Oscillators for cw transmit on f
+void ComposeCw(unsigned long f, bool usb) {
+  //turn off the second local oscillator and the bfo
+  si5351::SetFreq(0, 0);
+  si5351::SetFreq(1, 0);
+
+  //shif the first oscillator to the tx frequency directly
+  //the key up and key down will toggle the carrier unbalancing
+  //the exact cw frequency is the tuned frequency + sidetone
+  if (usb)
+    SetVfo(f + settings.cw_side_tone);
+  else
+    SetVfo(f - settings.cw_side_tone);
+}
+
+/**
+ * Rebuild the rx and tx images from the current state and put the one
+ * for the current rx/tx state back on the chip. While transmitting with
+ * rit or split the dial holds the tx side and the rx side is kept aside.
+ */
+void RefreshImages() {
+  unsigned long rx_f = frequency, tx_f = frequency;
+  bool rx_usb = status.is_usb, tx_usb = status.is_usb;
+
+  if (status.shift_mode == SHIFT_RIT) {
+    if (in_tx) rx_f = rit_rx_frequency;
+    else tx_f = rit_tx_frequency;
+  } else if (status.shift_mode == SHIFT_SPLIT) {
+    unsigned long other_f = status.vfo_a_active ? settings.vfo_b : settings.vfo_a;
+    bool other_usb = status.vfo_a_active ? settings.vfo_b_usb : settings.vfo_a_usb;
+    if (in_tx) {
+      rx_f = other_f;
+      rx_usb = other_usb;
+    } else {
+      tx_f = other_f;
+      tx_usb = other_usb;
+    }
+  }
+
+  si5351::Begin();  // only the difference to the active image goes out
+  ComposeSsb(rx_f, rx_usb);
+  si5351::SaveImage(&rx_image);
+  ComposeSsb(tx_f, tx_usb);
+  si5351::SaveImage(&tx_ssb_image);
+  ComposeCw(tx_f, tx_usb);
+  si5351::SaveImage(&tx_cw_image);
+  if (!in_tx)
+    si5351::LoadImage(&rx_image);
+  else if (!tx_cw)
+    si5351::LoadImage(&tx_ssb_image);
+  // else the cw image composed last is the active one
+  si5351::Commit();
+  images_stale = false;
+}
+
+void UpdateImages() {
+  if (images_stale) RefreshImages();
+}
+
+void Changed(unsigned char what) {
+  changed |= what;
+  if (what & (CHANGED_FREQUENCY | CHANGED_MODE | CHANGED_SHIFT | CHANGED_VFO | CHANGED_OSC))
+    images_stale = true;
+}
+
+void SaveVfos() {
+  EEPROM.put(eeprom::VFO_A, settings.vfo_a);
+  EEPROM.put(eeprom::VFO_A_USB, settings.vfo_a_usb);
+  EEPROM.put(eeprom::VFO_B, settings.vfo_b);
+  EEPROM.put(eeprom::VFO_B_USB, settings.vfo_b_usb);
+}
+
+// Once per scheduler tick, after the active app
+void DispatchChanges() {
+  unsigned char what = changed;
+  changed = 0;
+  UpdateImages();  // prepare tx oscillator settings ahead of ptt
+  if (!what) return;
+  power::Activity();
+  if (what & SAVE_VFOS) SaveVfos();
+  ui::Changed(what);
+  cat::Changed(what);
+}
+
 /**
  * This is the most frequently called function that configures the 
  * radio to a particular frequeny, sideband and sets up the transmit filters
@@ -147,27 +305,50 @@ void SetFrequency(unsigned long f) {
   if (f > HIGHEST_FREQ)
     f = HIGHEST_FREQ;
 
-  SetTxFilters(f);
-
-  if (status.is_usb) {
-    si5351::SetFreq(2, first_if + f);
-    si5351::SetFreq(1, first_if + settings.usb_carrier);
-  } else{
-    si5351::SetFreq(2, first_if + f);
-    si5351::SetFreq(1, first_if - settings.usb_carrier);
+  SetDial(f);
+  Changed(CHANGED_FREQUENCY);
+  if (in_tx) {  // the transmit image is on air, rebuild them all now
+    RefreshImages();
+    return;
   }
-    
-  frequency = f;
+  si5351::Begin();
+  ComposeSsb(f, status.is_usb);
+  si5351::Commit();
+}
 
-  unsigned int khz = frequency / 1000;
-  unsigned char i = 0;
-  for (i = 0; i < 12; i++) {
-    if ((khz >= BAND_LIST[i].min_khz) &&
-        (khz <= BAND_LIST[i].max_khz)) {
-      break;
-    }
+/**
+ * Receive on f for a moment: only the first oscillator moves, the dial,
+ * tx filters, band and display stay as they are and no change event is
+ * raised. For sweeps, RestoreDial() puts the receiver back on the dial.
+ */
+void TuneFast(unsigned long f) {
+  si5351::Begin();
+  SetVfo(first_if + f);
+  si5351::Commit();
+}
+
+void RestoreDial() {
+  RefreshImages();
+}
+
+// Swap the dial and the other VFO, without retuning
+void ExchangeVfos(bool save) {
+  if (status.vfo_a_active) {
+    settings.vfo_a = frequency;
+    settings.vfo_a_usb = status.is_usb;
+
+    status.vfo_a_active = false;
+    frequency = settings.vfo_b;
+    status.is_usb = settings.vfo_b_usb;
+  } else {
+    settings.vfo_b = frequency;
+    settings.vfo_b_usb = status.is_usb;
+
+    status.vfo_a_active = true;
+    frequency = settings.vfo_a;
+    status.is_usb = settings.vfo_a_usb;
   }
-  active_band = i;
+  if (save) Changed(SAVE_VFOS);
 }
 
 /**
@@ -177,32 +358,30 @@ void SetFrequency(unsigned long f) {
  * CW offest is calculated as lower than the operating frequency when in LSB mode, and vice versa in USB mode
  */
 void TxStart(bool start_cw) {
+  UpdateImages();  // normally already done in the background
+
+  unsigned char sreg = SREG;
+  cli();  // no swr trip between the test and the relay
   if (!status.tx_inhibit)
     digitalWrite(hw::TX_RX, 1);
+  SREG = sreg;
   in_tx = 1;
-  
+  swr::Start();
+  tx_cw = start_cw && !status.tx_inhibit;
+  power::Wake();  // the clocks deep idle holds down
+  si5351::LoadImage(tx_cw ? &tx_cw_image : &tx_ssb_image);
+  perf::EndOnBus(perf::PTT);
+
+  // the oscillators are on the tx frequency already, move the dial there
   if (status.shift_mode == SHIFT_RIT) { // rit
     //save the current as the rx frequency
     rit_rx_frequency = frequency;
-    SetFrequency(rit_tx_frequency);
+    SetDial(rit_tx_frequency);
   } else if (status.shift_mode == SHIFT_SPLIT) { // split
-    VfoSwap(/*save=*/false);
-  }
-
-  if (start_cw && !status.tx_inhibit) {
-    //turn off the second local oscillator and the bfo
-    si5351::SetFreq(0, 0);
-    si5351::SetFreq(1, 0);
-
-    //shif the first oscillator to the tx frequency directly
-    //the key up and key down will toggle the carrier unbalancing
-    //the exact cw frequency is the tuned frequency + sidetone
-    if (status.is_usb)
-      si5351::SetFreq(2, frequency + settings.cw_side_tone);
-    else
-      si5351::SetFreq(2, frequency - settings.cw_side_tone); 
+    ExchangeVfos(/*save=*/false);
+    SetDial(frequency);
   }
-  ui::UpdateDisplay();
+  Changed(CHANGED_TX);
 }
 
 void TxStartSsb() {
@@ -215,17 +394,21 @@ void TxStartCw() {
 
 void TxStop() {
   in_tx = 0;
+  tx_cw = false;
 
   digitalWrite(hw::TX_RX, 0);
-  si5351::SetFreq(0, settings.usb_carrier);  //set back the carrrier oscillator, cw tx switches it off
+  swr::Stop();
+  ui::ReleaseGraph();  // the meter rows, the tuning screen draws text there
 
   if (status.shift_mode == SHIFT_RIT ) { // rit
-    frequency = rit_rx_frequency;
+    SetDial(rit_rx_frequency);
   } else if (status.shift_mode == SHIFT_SPLIT ) { // split
-    VfoSwap(/*save=*/false);
+    ExchangeVfos(/*save=*/false);
+    SetDial(frequency);
   }
-  SetFrequency(frequency);
-  ui::UpdateDisplay();
+  UpdateImages();  // in case something changed while transmitting
+  si5351::LoadImage(&rx_image);
+  Changed(CHANGED_TX);
 }
 
 /**
@@ -237,13 +420,14 @@ void RitEnable(unsigned long f) {
   //save the non-rit frequency back into the VFO memory
   //as RIT is a temporary shift, this is not saved to EEPROM
   rit_tx_frequency = f;
+  Changed(CHANGED_SHIFT);
 }
 
 void RitDisable() {
   if (status.shift_mode == SHIFT_RIT) {
     status.shift_mode = SHIFT_NONE;
+    Changed(CHANGED_SHIFT);
     SetFrequency(rit_tx_frequency);
-    ui::UpdateDisplay();
   }
 }
 
@@ -255,6 +439,7 @@ void CwSpeedSet(unsigned int speed) {
 void CwToneSet(unsigned int tone) {
   settings.cw_side_tone = tone;
   EEPROM.put(eeprom::CW_SIDE_TONE, settings.cw_side_tone);
+  Changed(CHANGED_OSC);
 }
 
 void CwDelayTimeSet(unsigned int delay_time) {
@@ -262,6 +447,11 @@ void CwDelayTimeSet(unsigned int delay_time) {
   EEPROM.put(eeprom::CW_DELAY_TIME, settings.cw_delay_time);
 }
 
+void SwrLimitSet(unsigned char limit) {
+  settings.swr_limit = limit;
+  EEPROM.put(eeprom::SWR_LIMIT, settings.swr_limit);
+}
+
 void IambicKeySet(unsigned char key) {
   settings.iambic_key = key;
   EEPROM.put(eeprom::IAMBIC_KEY, settings.iambic_key);
@@ -275,34 +465,14 @@ void IambicKeySet(unsigned char key) {
 
 void SidebandSet(bool usb) {
   status.is_usb = usb;
+  Changed(CHANGED_MODE);
   SetFrequency(frequency);
 }
 
 void VfoSwap(bool save) {
   RitDisable();
-  if (status.vfo_a_active) {
-    settings.vfo_a = frequency;
-    settings.vfo_a_usb = status.is_usb;
-    if (save) {
-      EEPROM.put(eeprom::VFO_A, settings.vfo_a);
-      EEPROM.put(eeprom::VFO_A_USB, settings.vfo_a_usb);
-    }
-
-    status.vfo_a_active = false;
-    frequency = settings.vfo_b;
-    status.is_usb = settings.vfo_b_usb;
-  } else {
-    settings.vfo_b = frequency;
-    settings.vfo_b_usb = status.is_usb;
-    if (save) {
-      EEPROM.put(eeprom::VFO_B, settings.vfo_b);
-      EEPROM.put(eeprom::VFO_B_USB, settings.vfo_b_usb);
-    }
-
-    status.vfo_a_active = true;
-    frequency = settings.vfo_a;
-    status.is_usb = settings.vfo_a_usb;
-  }
+  ExchangeVfos(save);
+  Changed(CHANGED_VFO | CHANGED_MODE);
   SetFrequency(frequency);
 }
 
@@ -312,30 +482,26 @@ void VfoCopy(bool save) {
   settings.vfo_a_usb = status.is_usb;
   settings.vfo_b = frequency;
   settings.vfo_b_usb = status.is_usb;
-  if (save) {
-    EEPROM.put(eeprom::VFO_A, settings.vfo_a);
-    EEPROM.put(eeprom::VFO_A_USB, settings.vfo_a_usb);
-    EEPROM.put(eeprom::VFO_B, settings.vfo_b);
-    EEPROM.put(eeprom::VFO_B_USB, settings.vfo_b_usb);
-  }
+  Changed(save ? CHANGED_VFO | SAVE_VFOS : CHANGED_VFO);
 }
 
 void SplitEnable() {
   status.shift_mode = SHIFT_SPLIT;
+  Changed(CHANGED_SHIFT);
 }
 
 void SplitDisable() {
   if (status.shift_mode == SHIFT_SPLIT) {
     status.shift_mode = SHIFT_NONE;
+    Changed(CHANGED_SHIFT);
   }
 }
 
-void SetUsbCarrier(unsigned long long carrier) {
+void SetUsbCarrier(unsigned long carrier) {
   settings.usb_carrier = carrier;
   EEPROM.put(eeprom::USB_CARRIER, settings.usb_carrier);
 
-  si5351::SetFreq(0, settings.usb_carrier);
-  SetFrequency(frequency);
+  SetFrequency(frequency);  // the carrier oscillator is part of every image
 }
 
 void SetMasterCal(long int cal) {
@@ -360,6 +526,7 @@ void ResetSettingsAndHalt() {
   settings.vfo_b_usb = true;
   settings.iambic_key = 1;
   settings.cw_delay_time = 60;
+  settings.swr_limit = swr::LIMIT_DEFAULT;
 
   EEPROM.put(eeprom::MASTER_CAL, settings.master_cal);
   EEPROM.put(eeprom::USB_CARRIER, settings.usb_carrier);
@@ -371,13 +538,16 @@ void ResetSettingsAndHalt() {
   EEPROM.put(eeprom::VFO_B_USB, settings.vfo_b_usb);
   EEPROM.put(eeprom::IAMBIC_KEY, settings.iambic_key);
   EEPROM.put(eeprom::CW_DELAY_TIME, settings.cw_delay_time);
+  EEPROM.put(eeprom::SWR_LIMIT, settings.swr_limit);
 
   char magicNr = eeprom::MAGIC_NR; // TODO unneded variable
   EEPROM.put(eeprom::MAGIC_ADDR, magicNr);
 
-  ui::u8x8.clear();
-  ui::PrintLine(2, "EEPROM RESET");
-  ui::PrintLine(4, "TURN OFF POWER");
+  ui::Clear();
+  ui::PrintLine_P(2, PSTR("EEPROM RESET"));
+  ui::PrintLine_P(4, PSTR("TURN OFF POWER"));
+  ui::Flush();
+  watchdog::Disable();
   while (1) {}
 }
 
@@ -405,6 +575,9 @@ void InitSettings() {
   EEPROM.get(eeprom::VFO_B_USB, settings.vfo_b_usb);
   EEPROM.get(eeprom::IAMBIC_KEY, settings.iambic_key);
   EEPROM.get(eeprom::CW_DELAY_TIME, settings.cw_delay_time);
+  EEPROM.get(eeprom::SWR_LIMIT, settings.swr_limit);
+  if (settings.swr_limit < swr::LIMIT_MIN || settings.swr_limit > swr::LIMIT_MAX)
+    settings.swr_limit = swr::LIMIT_DEFAULT;  // written before the limit existed
 
   // TODO - EEPROM
   first_if = 45005000L; // should be eeprom
@@ -427,6 +600,7 @@ void InitOscillators() {
   si5351::Init();
   si5351::SetCalibration(settings.master_cal);
   si5351::SetFreq(0, settings.usb_carrier);
+  Changed(CHANGED_OSC);
 }
 
 void InitPorts() {
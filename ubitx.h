@@ -1,6 +1,9 @@
 #ifndef UBITX_H_
 #define UBITX_H_
 
+#include <avr/pgmspace.h>
+#include "bcd.h"
+
 namespace ubitx {
 
 /**
@@ -24,6 +27,10 @@ namespace ubitx {
 const unsigned long LOWEST_FREQ  =  1000000l;
 const unsigned long HIGHEST_FREQ = 30000000l;
 
+// true tunes the first oscillator (CLK2) by moving PLLB behind an integer
+// output divider, false uses the fractional output msynth off PLLA (1 Hz steps)
+const bool VFO_PLL_TUNING = false;
+
 /** 
  * The Raduino board is the size of a standard 16x2 LCD panel. It has three connectors:
  * 
@@ -46,7 +53,7 @@ extern struct Status {
   unsigned char shift_mode; // 0 none, 1 rit, 2 split
   bool vfo_a_active;
   bool is_usb;
-  bool tx_inhibit;
+  volatile bool tx_inhibit;  // also set by the swr ADC interrupt
 } status;
 
 extern struct Settings {
@@ -60,36 +67,43 @@ extern struct Settings {
   bool vfo_b_usb;
   unsigned char iambic_key; // 0 stright, 1 a, 2 b
   int cw_delay_time;
+  unsigned char swr_limit;  // tenths, 30 trips above 3.0:1
 } settings;
 
-// Size before this struct/array : 20576 / 1090
-// Size after                      20874 / 1307 .. thats a lot
+// In flash, read with pgm_read_word() / the _P string functions. In RAM
+// it cost 217 bytes.
 struct BandList {
   char name[5];
   unsigned int min_khz;
   unsigned int max_khz;
 };
 
-const BandList BAND_LIST[] = {
-  {"160M",  1810,  2000},
-  {" 80M",  3500,  3800},
-  {" 60M",  5351,  5367},
-  {" 40M",  7000,  7200},
-  {" 30M", 10100, 10150},
-  {" 20M", 14000, 14350},
-  {" 17M", 18068, 18168},
-  {" 15M", 21000, 21450},
-  {" 12M", 24890, 24990},
-  {"  CB", 26953, 27417},
-  {" 10M", 28000, 29700},
-  {"    ",     0, 30000}
-};
+const unsigned char BANDS = 12;  // the last one catches the rest
+extern const BandList BAND_LIST[BANDS] PROGMEM;
 extern unsigned char active_band;
 
 extern unsigned long frequency;
+extern bcd::Number frequency_bcd;  // the same, for display and CAT
 
 extern char in_tx;
 
+/**
+ * Change events. The radio functions below only record what they changed,
+ * DispatchChanges() then hands the union of everything since its last run
+ * to the consumers once: the display, the ready made tx oscillator images,
+ * the EEPROM and the cached CAT status.
+ */
+const unsigned char CHANGED_FREQUENCY = 0x01;  // the dial
+const unsigned char CHANGED_MODE      = 0x02;  // sideband
+const unsigned char CHANGED_SHIFT     = 0x04;  // rit or split on / off
+const unsigned char CHANGED_VFO       = 0x08;  // active vfo or the vfo memories
+const unsigned char CHANGED_TX        = 0x10;  // rx / tx, the dial may follow
+const unsigned char CHANGED_OSC       = 0x20;  // carrier, calibration, cw tone
+const unsigned char SAVE_VFOS         = 0x40;  // vfo memories want writing to EEPROM
+
+void Changed(unsigned char what);
+void DispatchChanges();
+
 // Utility functions
 void ActiveDelay(unsigned int delay_by);
 
@@ -105,8 +119,11 @@ void RitEnable(unsigned long f);
 void CwSpeedSet(unsigned int wpm);
 void CwToneSet(unsigned int tone);
 void CwDelayTimeSet(unsigned int delay_time);
+void SwrLimitSet(unsigned char limit);
 void SetFrequency(unsigned long f);
-void SetUsbCarrier(unsigned long long carrier);
+void TuneFast(unsigned long f);
+void RestoreDial();
+void SetUsbCarrier(unsigned long carrier);
 void SetMasterCal(long int cal);
 void SidebandSet(bool usb);
 void IambicKeySet(unsigned char key);
@@ -115,6 +132,7 @@ void SplitEnable();
 void TxStartSsb();
 void TxStartCw();
 void TxStop();
+void UpdateImages();
 void VfoSwap(bool save);
 void VfoCopy(bool save);
 
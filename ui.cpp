@@ -4,118 +4,538 @@
  */
 #include "ui.h"
 #include <Arduino.h>
-#include <U8x8lib.h>
 #include "hw.h"
+#include "i2c.h"
 #include "ubitx.h"
 #include "mainloop.h"
+#include "menu.h"
+#include "perf.h"
+#include "scope.h"
 #include "keyer.h"
 
+// fonts_gen.h is made by tools/gen_fonts.py from tools/glyphs.txt. Set
+// UI_U8X8_FONTS to 1 to build with the full u8x8 fonts of U8g2 instead.
+#ifndef UI_U8X8_FONTS
+#define UI_U8X8_FONTS 0
+#endif
+#if UI_U8X8_FONTS
+// Only the font tables are taken from U8g2. With hardware i2c support it
+// also pulls in Wire, whose TWI interrupt clashes with the one of i2c.cpp
+// at link time.
+#include <U8x8lib.h>
+#ifdef U8X8_HAVE_HW_I2C
+#error "U8g2 built with U8X8_HAVE_HW_I2C: comment out its #define in U8x8lib.h, see README"
+#endif
+#define U8X8_MAINFONT u8x8_font_amstrad_cpc_extended_u
+#define U8X8_DIGITFONT u8x8_font_profont29_2x3_n
+#define FONTS_GENERATED 0
+#else
+#include "fonts_gen.h"           // only the glyphs shown
+#define FONTS_GENERATED 1
+#endif
+
 namespace ui {
 
-unsigned long last_v_update = 0;
-int prev_voltage = -1;
+const unsigned char UPDATE_FREQUENCY = 1;
+const unsigned char UPDATE_ALL = 2;
+unsigned char update_pending = 0;
+
+/**
+ * Shadow of the panel, one entry per 8x8 tile: the glyph and how it is
+ * drawn. The Draw functions only change the shadow and mark the tiles
+ * that changed, Flush() then renders and sends just those. Redrawing a
+ * whole screen costs no bus time for the tiles that look the same.
+ */
+const unsigned char KIND_TALL = 1;    // MAINFONT stretched over two, part 0 is the top
+const unsigned char KIND_DIGIT = 2;   // DIGITFONT over 2x3, parts row by row
+const unsigned char KIND_BAR = 3;     // graph, glyph is the column and part the row
+const unsigned char INVERSE = 0x80;
+
+unsigned char tile_glyph[ROWS][COLUMNS];
+unsigned char tile_attr[ROWS][COLUMNS];
+unsigned int dirty[ROWS];             // bit per column
+unsigned char inverse = 0;
+unsigned char graph[COLUMNS * 8];     // bar heights in pixels
+unsigned char graph_top = ROWS;
+
+void SetTile(unsigned char x, unsigned char y, unsigned char glyph,
+             unsigned char attr) {
+  if (x >= COLUMNS || y >= ROWS) return;
+  if (glyph == ' ' && !(attr & INVERSE)) glyph = attr = 0;  // blank in any font
+  if (tile_glyph[y][x] == glyph && tile_attr[y][x] == attr) return;
+  tile_glyph[y][x] = glyph;
+  tile_attr[y][x] = attr;
+  dirty[y] |= 1u << x;
+}
+
+void Clear() {
+  for (unsigned char y = 0; y < ROWS; y++) ClearLine(y);
+  ReleaseGraph();
+}
+
+void ClearLine(unsigned char y) {
+  for (unsigned char x = 0; x < COLUMNS; x++) ClearTile(x, y);
+}
+
+void SetInverse(bool on) {
+  inverse = on ? INVERSE : 0;
+}
+
+void ClearTile(unsigned char x, unsigned char y) {
+  SetTile(x, y, 0, 0);
+}
+
+void Draw1x2Glyph(unsigned char x, unsigned char y, char c) {
+  SetTile(x, y, c, KIND_TALL | inverse);
+  SetTile(x, y + 1, c, KIND_TALL | 1 << 2 | inverse);
+}
+
+void Draw1x2String(unsigned char x, unsigned char y, const char *s) {
+  while (*s) Draw1x2Glyph(x++, y, *s++);
+}
+
+void Draw1x2String_P(unsigned char x, unsigned char y, PGM_P s) {
+  char c;
+  while ((c = pgm_read_byte(s++))) Draw1x2Glyph(x++, y, c);
+}
+
+void DrawDigit(unsigned char x, unsigned char y, char c) {
+  for (unsigned char part = 0; part < 6; part++) {
+    SetTile(x + (part & 1), y + part / 2, c, KIND_DIGIT | part << 2 | inverse);
+  }
+}
+
+void DrawDigits(unsigned char x, unsigned char y, const char *s) {
+  for (; *s; x += 2) DrawDigit(x, y, *s++);
+}
+
+void ClearGraph(unsigned char top) {
+  graph_top = top;
+  memset(graph, 0, sizeof(graph));
+  for (unsigned char y = top; y < ROWS; y++) {
+    for (unsigned char x = 0; x < COLUMNS; x++) SetTile(x, y, x, KIND_BAR | y << 2);
+    dirty[y] = 0xffff;
+  }
+}
+
+void ReleaseGraph() {
+  graph_top = ROWS;
+}
+
+// Only the tiles of the column between the old and the new top change
+void DrawBar(unsigned char column, unsigned char height) {
+  if (column >= COLUMNS * 8) return;
+  if (height > (ROWS - graph_top) * 8) height = (ROWS - graph_top) * 8;
+  unsigned char old = graph[column];
+  if (old == height) return;
+  graph[column] = height;
+  unsigned char lo = old < height ? old : height;
+  unsigned char hi = old < height ? height : old;
+  // rows from the new or old top down to the lower of the two, counting
+  // up so row 0 cannot wrap an unsigned counter
+  for (unsigned char y = ROWS - 1 - (hi - 1) / 8; y <= ROWS - 1 - lo / 8; y++) {
+    dirty[y] |= 1u << (column / 8);
+  }
+}
+
+#if FONTS_GENERATED
+// Text glyphs come stretched already, so both kinds are a plain copy
+void LoadTile(unsigned char glyph, unsigned char attr, unsigned char *tile) {
+  unsigned char kind = attr & 3;
+  unsigned char part = (attr >> 2) & 7;
+  unsigned char slot = fonts::NONE;
+  if (glyph >= fonts::MAP_FIRST && glyph < fonts::MAP_FIRST + fonts::MAP_SIZE) {
+    slot = pgm_read_byte((kind == KIND_DIGIT ? fonts::DIGIT_MAP : fonts::TEXT_MAP) +
+                         glyph - fonts::MAP_FIRST);
+  }
+  if (slot == fonts::NONE) {
+    memset(tile, 0, 8);
+  } else if (kind == KIND_DIGIT) {
+    memcpy_P(tile, fonts::DIGIT + slot * 48 + part * 8, 8);
+  } else {
+    memcpy_P(tile, fonts::TEXT + slot * 16 + part * 8, 8);
+  }
+}
+#else
+// Same layout as u8x8: after a 4 byte header each glyph has its tiles
+// row by row, 8 column bytes per tile. 0 for glyphs the font lacks.
+const uint8_t *GlyphTile(const uint8_t *font, unsigned char glyph,
+                         unsigned char part) {
+  unsigned char first = pgm_read_byte(font);
+  unsigned char last = pgm_read_byte(font + 1);
+  unsigned char tiles = pgm_read_byte(font + 2) * pgm_read_byte(font + 3);
+  if (glyph < first || glyph > last) return 0;
+  return font + 4 + ((glyph - first) * tiles + part) * 8;
+}
+
+// Doubles each of the low 4 bits, so a tile row becomes two
+unsigned char Stretch(unsigned char nibble) {
+  unsigned char b = 0;
+  for (unsigned char i = 0; i < 4; i++) {
+    if (nibble & 1 << i) b |= 3 << (i * 2);
+  }
+  return b;
+}
+
+void LoadTile(unsigned char glyph, unsigned char attr, unsigned char *tile) {
+  unsigned char kind = attr & 3;
+  unsigned char part = (attr >> 2) & 7;
+  const uint8_t *p = GlyphTile(kind == KIND_DIGIT ? U8X8_DIGITFONT : U8X8_MAINFONT,
+                               glyph, kind == KIND_DIGIT ? part : 0);
+  for (unsigned char i = 0; i < 8; i++) {
+    unsigned char b = p ? pgm_read_byte(p + i) : 0;
+    tile[i] = kind == KIND_TALL ? Stretch(part ? b >> 4 : b) : b;
+  }
+}
+#endif
+
+// Bars grow up from the bottom row, bit 7 is the lowest pixel of a tile
+void LoadBar(unsigned char x, unsigned char y, unsigned char *tile) {
+  unsigned char base = (ROWS - 1 - y) * 8;  // height at the bottom of the tile
+  for (unsigned char i = 0; i < 8; i++) {
+    unsigned char h = graph[x * 8 + i];
+    unsigned char n = h > base ? h - base : 0;
+    tile[i] = n >= 8 ? 0xff : 0xff << (8 - n);
+  }
+}
+
+// Renders one tile from PROGMEM into the open i2c transaction
+void SendTile(unsigned char glyph, unsigned char attr) {
+  unsigned char tile[8];
+  if ((attr & 3) == KIND_BAR)
+    LoadBar(glyph, attr >> 2 & 7, tile);
+  else
+    LoadTile(glyph, attr, tile);
+  unsigned char invert = attr & INVERSE ? 0xff : 0;
+  for (unsigned char i = 0; i < 8; i++) i2c::Write(tile[i] ^ invert);
+}
+
+/**
+ * SSD1306 writes, no display library. A run of tiles in one row is a
+ * single transaction: the page and start column as continued commands,
+ * then the tile data in one burst, the column pointer steps on by itself.
+ */
+const unsigned char OLED_ADDR = 0x3C;
+const unsigned char COMMANDS = 0x00;    // all bytes to the end are commands
+const unsigned char CO_COMMAND = 0x80;  // one command byte, more control bytes follow
+const unsigned char DATA = 0x40;        // all bytes to the end are display data
+const unsigned char RUN_MAX = (i2c::MAX_LOW - 7) / 8;
+
+// What u8x8 sends to a 128x64 "noname" SSD1306, in page addressing mode
+const unsigned char INIT_SEQUENCE[] PROGMEM = {
+  0xAE,                                 // display off
+  0xD5, 0x80,                           // clock divide ratio and oscillator
+  0xA8, 0x3F,                           // multiplex ratio, 64 lines
+  0xD3, 0x00,                           // display offset
+  0x40,                                 // start line 0
+  0x8D, 0x14,                           // charge pump on
+  0x20, 0x02,                           // page addressing, what SendRun() expects
+  0xA1,                                 // segment remap
+  0xC8,                                 // COM scan reversed
+  0xDA, 0x12,                           // COM pins configuration
+  0x81, 0xCF,                           // contrast
+  0xD9, 0xF1,                           // pre-charge period
+  0xDB, 0x40,                           // VCOMH deselect level
+  0x2E,                                 // scrolling off
+  0xA4,                                 // show the RAM contents
+  0xA6,                                 // not inverted
+};
+
+// The panel keeps its RAM while off, on again shows the same screen
+void SetPowerSave(bool on) {
+  i2c::Begin(OLED_ADDR, i2c::PRIO_LOW);
+  i2c::Write(COMMANDS);
+  i2c::Write(on ? 0xAE : 0xAF);
+  i2c::End();
+}
+
+// The panel RAM holds noise after power up, so the blank shadow goes out
+// in full before the panel is switched on
+void Init() {
+  delay(100);                           // panel power up, as long as u8x8 waits
+  // the SSD1306 modules run fine well above the 400 kHz of the datasheet
+  i2c::SetClock(OLED_ADDR, 800000);
+  i2c::Begin(OLED_ADDR, i2c::PRIO_LOW);
+  i2c::Write(COMMANDS);
+  for (unsigned char i = 0; i < sizeof(INIT_SEQUENCE); i++) {
+    i2c::Write(pgm_read_byte(INIT_SEQUENCE + i));
+  }
+  i2c::End();
+  for (unsigned char y = 0; y < ROWS; y++) dirty[y] = 0xffff;
+  Flush();
+  SetPowerSave(false);
+}
+
+void SendRun(unsigned char x, unsigned char y, unsigned char n) {
+  unsigned char column = x * 8;
+  i2c::Begin(OLED_ADDR, i2c::PRIO_LOW);
+  i2c::Write(CO_COMMAND);
+  i2c::Write(0xB0 | y);                 // page
+  i2c::Write(CO_COMMAND);
+  i2c::Write(column & 0x0f);            // column, low nibble
+  i2c::Write(CO_COMMAND);
+  i2c::Write(0x10 | column >> 4);       // column, high nibble
+  i2c::Write(DATA);
+  for (unsigned char i = 0; i < n; i++) SendTile(tile_glyph[y][x + i], tile_attr[y][x + i]);
+  i2c::End();
+}
+
+bool Dirty() {
+  for (unsigned char y = 0; y < ROWS; y++) {
+    if (dirty[y]) return true;
+  }
+  return false;
+}
+
+// Rows in the order they are sent: the frequency digits, then the status
+// line with the TX indicator, the cosmetic rest last
+const unsigned char ROW_ORDER[ROWS] PROGMEM = {3, 4, 5, 1, 2, 6, 7, 0};
+
+/**
+ * Sends changed tiles, neighbours in a row together, until budget_us is
+ * used up or the display queue has no room for the next run. Never waits
+ * for the bus, whatever is left goes out on the next call.
+ */
+void FlushSome(unsigned int budget_us) {
+  unsigned long start = micros();
+  for (unsigned char r = 0; r < ROWS; r++) {
+    unsigned char y = pgm_read_byte(ROW_ORDER + r);
+    unsigned char x = 0;
+    while (x < COLUMNS && dirty[y] >> x) {  // a shift by 16 is undefined
+      if (!(dirty[y] >> x & 1)) {
+        x++;
+        continue;
+      }
+      unsigned char n = 1;
+      while (x + n < COLUMNS && (dirty[y] >> (x + n) & 1) && n < RUN_MAX) n++;
+      if (i2c::Free(i2c::PRIO_LOW) < 9 + n * 8) return;  // header and commands
+      if (micros() - start > budget_us) return;
+      SendRun(x, y, n);
+      dirty[y] &= ~(((1u << n) - 1) << x);
+      x += n;
+    }
+  }
+}
+
+// Everything, waiting for the bus as needed
+void Flush() {
+  while (Dirty()) FlushSome(0xffff);
+}
+
+// Bytes queued, the time until the last of them is queued and until it
+// is on the wire
+void Measure(const __FlashStringHelper *name) {
+  unsigned long bytes = i2c::bytes[i2c::PRIO_LOW];
+  unsigned long start = micros();
+  Flush();
+  unsigned long queued = micros();
+  while (i2c::Sending(i2c::PRIO_LOW)) {}
+  unsigned long done = micros();
+  Serial.print(name);
+  Serial.print(' ');
+  Serial.print(i2c::bytes[i2c::PRIO_LOW] - bytes);
+  Serial.print(' ');
+  Serial.print(queued - start);
+  Serial.print(' ');
+  Serial.println(done - start);
+}
 
-U8X8_SSD1306_128X64_NONAME_HW_I2C u8x8(U8X8_PIN_NONE);
+// The cpu time to render one tile, from the shadow as it is
+void MeasureGlyph() {
+  const unsigned char N = 128;
+  unsigned char tile[8];
+  unsigned long start = micros();
+  for (unsigned char i = 0; i < N; i++) {
+    unsigned char y = i / COLUMNS % ROWS, x = i % COLUMNS;
+    LoadTile(tile_glyph[y][x], tile_attr[y][x], tile);
+  }
+  unsigned long us = micros() - start;
+  Serial.print(F("GLYPH "));
+  Serial.print(FONTS_GENERATED ? F("GEN ") : F("U8X8 "));
+  Serial.print(us / N);
+  Serial.print('.');
+  Serial.println(us * 10 / N % 10);
+}
+
+// Sends the whole shadow and then the two lowest frequency digits, the
+// usual tuning step, and prints name bytes cpu_us total_us for both.
+// Then the render time per tile.
+void Benchmark() {
+  while (i2c::Sending(i2c::PRIO_LOW)) {}
+  for (unsigned char y = 0; y < ROWS; y++) dirty[y] = 0xffff;
+  Measure(F("FRAME"));
+  for (unsigned char y = 3; y < 6; y++) dirty[y] = 0xf000;
+  Measure(F("FREQ"));
+  MeasureGlyph();
+}
 
 // The generic routine to display one line on the LCD
 void PrintLine(unsigned char line_nr, const char *c) {
   if (c[0] == 0) {
-    u8x8.clearLine(line_nr);
-    u8x8.clearLine(line_nr + 1);
+    ClearLine(line_nr);
+    ClearLine(line_nr + 1);
     return;
   }
 
-  u8x8.draw1x2String(1, line_nr, c);
+  Draw1x2String(1, line_nr, c);
 
   // add white spaces until the end of the 16 characters line is reached
   for (unsigned char i = strlen(c); i < 15; i++) {
-    u8x8.draw1x2Glyph(i + 1, line_nr, ' ');
+    Draw1x2Glyph(i + 1, line_nr, ' ');
   }
 }
 
 
 void PrintLineValue(unsigned char line_nr, const char *c, const char *v) {
-  u8x8.draw1x2String(1, line_nr, c);
-  u8x8.draw1x2String(15 - strlen(v) + 1, line_nr, v);
+  Draw1x2String(1, line_nr, c);
+  Draw1x2String(15 - strlen(v) + 1, line_nr, v);
   for (unsigned char i = strlen(c) + 1; i <= 15 - strlen(v); i++) {
-    u8x8.draw1x2Glyph(i, line_nr, ' ');
+    Draw1x2Glyph(i, line_nr, ' ');
   }
 }
 
-// this builds up the top line of the display with frequency and mode
+// A flash string into a line buffer of 16, as much as a line shows
+char *LoadLine(char *line, PGM_P s) {
+  strncpy_P(line, s, 15);
+  line[15] = 0;
+  return line;
+}
+
+void PrintLine_P(unsigned char line_nr, PGM_P c) {
+  char line[16];
+  PrintLine(line_nr, LoadLine(line, c));
+}
+
+void PrintLineValue_P(unsigned char line_nr, PGM_P c, const char *v) {
+  char line[16];
+  PrintLineValue(line_nr, LoadLine(line, c), v);
+}
+
+// The whole tuning screen. Every tile it owns is drawn, blanks too, so
+// whatever the menu or the scope left there is replaced without a clear
+// and tiles that look the same are not sent.
 void UpdateDisplay() {
+  ClearLine(0);
+  // in tx the swr meter owns the graph rows and, once it is up, its
+  // reading in row 1, see swr::Draw()
+  unsigned char bottom = ubitx::in_tx ? graph_top : ROWS;
+  for (unsigned char y = 1; y < bottom; y++) ClearTile(0, y);
+  for (unsigned char y = 3; y < 6; y++) ClearTile(11, y);  // the point
   if (ubitx::in_tx) {
     // 123456789012345
-    // ___________=TX=
-    u8x8.draw1x2String(1, 1, "           ");
-    u8x8.setInverseFont(1);
-    u8x8.draw1x2String(12, 1, keyer::cw_timeout > 0 ? " CW " : " TX ");
-    u8x8.setInverseFont(0);
+    // SWR 1.5____=TX=
+    // forward power bar graph in rows 6 and 7
+    if (graph_top == ROWS) Draw1x2String_P(1, 1, PSTR("        "));
+    Draw1x2String_P(9, 1, PSTR("   "));
+    SetInverse(true);
+    Draw1x2String_P(12, 1, keyer::cw_timeout > 0 ? PSTR(" CW ") : PSTR(" TX "));
+    SetInverse(false);
   } else {
     // 123456789012345
-    // ....__RIT_USB_A
+    // ______RIT_USB_A
     //           13.7V
+    Draw1x2String_P(1, 1, PSTR("      "));
     switch (ubitx::status.shift_mode) {
       case 0:
-        u8x8.draw1x2String(7, 1, "   ");
+        Draw1x2String_P(7, 1, PSTR("   "));
         break;
       case 1:
-        u8x8.draw1x2String(7, 1, "RIT");
+        Draw1x2String_P(7, 1, PSTR("RIT"));
         break;
       case 2:
-        u8x8.draw1x2String(7, 1, "SPL");
+        Draw1x2String_P(7, 1, PSTR("SPL"));
         break;
     }
-    u8x8.draw1x2Glyph(10, 1, ' ');
+    Draw1x2Glyph(10, 1, ' ');
 
-    u8x8.draw1x2String(11, 1, ubitx::status.is_usb ? "USB " : "LSB ");
-    u8x8.draw1x2Glyph(15, 1, ubitx::status.vfo_a_active ? 'A' : 'B');
+    Draw1x2String_P(11, 1, ubitx::status.is_usb ? PSTR("USB ") : PSTR("LSB "));
+    Draw1x2Glyph(15, 1, ubitx::status.vfo_a_active ? 'A' : 'B');
+    ClearLine(6);  // the tx meter
+    ClearLine(7);
   }
   PrintFrequency();
-
-  last_v_update = 0; prev_voltage = -1;
   UpdateVoltage();
 }
 
+// Straight from the BCD dial, 10 MHz down to 10 Hz
 void PrintFrequency() {
-  char b[11]; // holds string up to "4294967295\0"
-  ultoa(ubitx::frequency, b, DEC);
-
-  u8x8.setFont(U8X8_DIGITFONT);
+  const bcd::Number &f = ubitx::frequency_bcd;
   // one mhz digit if less than 10 M, two digits if more
-  unsigned char n = 0;
-  u8x8.drawGlyph(1, 3, ubitx::frequency < 10000000l ? ' ' : b[n++]);
-  u8x8.drawGlyph(3, 3, b[n++]);
-  u8x8.drawGlyph(5, 3, b[n++]);
-  u8x8.drawGlyph(7, 3, b[n++]);
-  u8x8.drawGlyph(9, 3, b[n++]);
+  unsigned char tens = bcd::Digit(f, 7);
+  DrawDigit(1, 3, tens ? '0' + tens : ' ');
+  DrawDigit(3, 3, '0' + bcd::Digit(f, 6));
+  DrawDigit(5, 3, '0' + bcd::Digit(f, 5));
+  DrawDigit(7, 3, '0' + bcd::Digit(f, 4));
+  DrawDigit(9, 3, '0' + bcd::Digit(f, 3));
   // .
-  u8x8.drawGlyph(12, 3, b[n++]);
-  u8x8.drawGlyph(14, 3, b[n++]);
-  u8x8.setFont(U8X8_MAINFONT);
+  DrawDigit(12, 3, '0' + bcd::Digit(f, 2));
+  DrawDigit(14, 3, '0' + bcd::Digit(f, 1));
 }
 
+// Runs as a 2 Hz task while the tuning screen is up, unchanged tiles
+// cost nothing. While transmitting the swr meter has the place and the ADC.
 void UpdateVoltage() {
-  if (last_v_update + 500 > millis()) return;
-  last_v_update = millis();
+  if (ubitx::in_tx) return;
   // 3.7 volts were tead as 189
   // 11.9V volts were read as 552:
   int cur_voltage = map(analogRead(hw::ANALOG_V), 189, 552, 37, 119);
   if (cur_voltage < 10) {
-    u8x8.draw1x2String(11, 6, "     ");
+    Draw1x2String_P(11, 6, PSTR("     "));
     return;
   }
-  if (cur_voltage != prev_voltage) {
-    char b[7]; // holds string up to "-32767\0"
-    prev_voltage = cur_voltage;
-    itoa(cur_voltage, b, DEC);
-    int n = 0;
-    u8x8.draw1x2Glyph(11, 6, cur_voltage < 100 ? ' ' : b[n++]);
-    u8x8.draw1x2Glyph(12, 6, b[n++]);
-    u8x8.draw1x2Glyph(13, 6, '.');
-    u8x8.draw1x2Glyph(14, 6, b[n++]);
-    u8x8.draw1x2Glyph(15, 6, 'V');
+  char b[7]; // holds string up to "-32767\0"
+  itoa(cur_voltage, b, DEC);
+  int n = 0;
+  Draw1x2Glyph(11, 6, cur_voltage < 100 ? ' ' : b[n++]);
+  Draw1x2Glyph(12, 6, b[n++]);
+  Draw1x2Glyph(13, 6, '.');
+  Draw1x2Glyph(14, 6, b[n++]);
+  Draw1x2Glyph(15, 6, 'V');
+}
+
+// Redraw the tuning screen at the next frame. Any number of frequency or
+// mode changes until then cost a single redraw, the oscillators are set
+// right away by the callers and never wait for the display.
+void RequestUpdate() {
+  update_pending |= UPDATE_ALL;
+}
+
+// Only the frequency digits, for previews drawn over other screens
+void RequestFrequency() {
+  update_pending |= UPDATE_FREQUENCY;
+}
+
+// Radio state changes as dispatched by ubitx. The menu and the scope own
+// the screen while they are up and the tuning screen is redrawn in full on return.
+void Changed(unsigned char what) {
+  if (mainloop::DoActiveApp == menu::DoMenu) return;
+  if (mainloop::DoActiveApp == scope::DoScope) return;
+  if (what & (ubitx::CHANGED_MODE | ubitx::CHANGED_SHIFT | ubitx::CHANGED_VFO |
+              ubitx::CHANGED_TX)) {
+    RequestUpdate();
+  } else if (what & ubitx::CHANGED_FREQUENCY) {
+    RequestFrequency();
+  }
+}
+
+// The display task, every FLUSH_MS. Redraws at most once per FRAME_MS
+// and sends a slice of the changed tiles each time.
+unsigned long last_frame = 0;
+
+void Run() {
+  if (!update_pending && !Dirty()) return;
+  unsigned int prof = perf::Enter();
+  unsigned char pending = 0;
+  if (update_pending && millis() - last_frame >= FRAME_MS) {
+    last_frame = millis();
+    pending = update_pending;
+    update_pending = 0;
+    if (pending & UPDATE_ALL) UpdateDisplay();
+    else PrintFrequency();
   }
+  FlushSome(SLICE_US);
+  if (pending) perf::End(perf::DISP);
+  perf::Leave(perf::P_DRAW, prof);
 }
 
 }  // namespace
@@ -1,14 +1,47 @@
 #ifndef UBITX_UI_H_
 #define UBITX_UI_H_
 
-#include <U8x8lib.h>
-
-#define U8X8_MAINFONT u8x8_font_amstrad_cpc_extended_u
-#define U8X8_DIGITFONT u8x8_font_profont29_2x3_n
+#include <avr/pgmspace.h>
 
 namespace ui {
 
-extern U8X8_SSD1306_128X64_NONAME_HW_I2C u8x8;
+// Redraws of the tuning screen at most every FRAME_MS, changes in between
+// are merged. The display task runs every FLUSH_MS and sends changed
+// tiles for up to SLICE_US each time, so a screen clear never holds up
+// the keyer, CAT or PTT.
+const unsigned int FRAME_MS = 50;
+const unsigned char FLUSH_MS = 2;
+const unsigned int SLICE_US = 1000;
+
+// The panel in 8x8 tiles
+const unsigned char COLUMNS = 16;
+const unsigned char ROWS = 8;
+
+// Drawing goes to a shadow of the panel, Flush() sends what changed.
+// The display task flushes every frame. The SSD1306 128x64 is driven
+// directly, its bytes are queued on the shared i2c bus.
+void Init();
+void SetPowerSave(bool on);
+void Clear();
+void ClearLine(unsigned char y);
+void SetInverse(bool on);
+void ClearTile(unsigned char x, unsigned char y);
+void Draw1x2Glyph(unsigned char x, unsigned char y, char c);
+void Draw1x2String(unsigned char x, unsigned char y, const char *s);
+void Draw1x2String_P(unsigned char x, unsigned char y, PGM_P s);
+void DrawDigit(unsigned char x, unsigned char y, char c);
+void DrawDigits(unsigned char x, unsigned char y, const char *s);
+
+// Bar graph from row top to the bottom, one bar per pixel column, at
+// most (ROWS - top) * 8 high. ClearGraph() claims the rows and zeroes the
+// bars, ReleaseGraph() or Clear() gives them back for text.
+void ClearGraph(unsigned char top);
+void ReleaseGraph();
+void DrawBar(unsigned char column, unsigned char height);
+
+void FlushSome(unsigned int budget_us);
+void Flush();
+void Benchmark();
 
 /** Refactoring ui more portable
  * Code size before program 20578 bytes / variables 1090 bytes.
@@ -16,8 +49,15 @@ extern U8X8_SSD1306_128X64_NONAME_HW_I2C u8x8;
  */
 void PrintLine(unsigned char line_nr, const char *c);
 void PrintLineValue(unsigned char line_nr, const char *c, const char *v);
+// The same with c in flash
+void PrintLine_P(unsigned char line_nr, PGM_P c);
+void PrintLineValue_P(unsigned char line_nr, PGM_P c, const char *v);
 void PrintFrequency();
 void UpdateDisplay();
+void RequestUpdate();
+void RequestFrequency();
+void Changed(unsigned char what);
+void Run();
 void UpdateVoltage();
 
 }  // namespace
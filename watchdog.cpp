@@ -0,0 +1,75 @@
+#include "watchdog.h"
+#include <Arduino.h>
+#include "hw.h"
+#include "sched.h"
+#include "ubitx.h"
+#include "ui.h"
+
+namespace watchdog {
+
+const unsigned int HANG_MAGIC = 0x5AA5;
+
+// Not touched by the startup code, keeps its value over a reset. The
+// bootloader clears MCUSR before the sketch starts, so the magic the
+// interrupt leaves is what tells a watchdog reset apart.
+Hang hang __attribute__((section(".noinit")));
+
+// Runs before the C runtime is set up. After a watchdog reset the
+// watchdog stays on at its shortest timeout and has to go before setup()
+// could be reached, which needs WDRF cleared first.
+void EarlyInit() __attribute__((naked, used, section(".init3")));
+void EarlyInit() {
+  MCUSR = 0;
+  wdt_disable();
+}
+
+// First timeout: make the radio safe and leave a note, the watchdog has
+// cleared WDIE by now so the second one resets unless sched::Run() gets
+// to Rearm() first
+ISR(WDT_vect) {
+  digitalWrite(hw::CW_KEY, 0);
+  digitalWrite(hw::TX_RX, 0);
+
+  hang.magic = HANG_MAGIC;
+  hang.in_tx = ubitx::in_tx;
+  hang.task[0] = 0;
+  hang.ms = 0;
+  if (sched::current < sched::task_count) {
+    strncpy_P(hang.task, sched::tasks[sched::current].name, sizeof(hang.task) - 1);
+    hang.task[sizeof(hang.task) - 1] = 0;
+    hang.ms = millis() - sched::started;
+  }
+}
+
+// After Report(): from here on only the interrupt sets the magic
+void Init() {
+  hang.magic = 0;
+  wdt_enable(WDTO_250MS);          // TIMEOUT_MS
+  WDTCSR |= _BV(WDIE);
+}
+
+void Disable() {
+  wdt_disable();
+}
+
+bool WasReset() {
+  return hang.magic == HANG_MAGIC;
+}
+
+// On the display at boot, the note is dropped once shown
+void Report() {
+  if (!WasReset()) return;
+  char b[16];
+  ui::PrintLine_P(3, PSTR("WATCHDOG RESET"));
+  if (hang.task[0]) strcpy(b, hang.task);
+  else strcpy_P(b, PSTR("IDLE"));
+  strcat_P(b, PSTR(" "));
+  utoa(hang.ms, b + strlen(b), DEC);
+  strcat_P(b, hang.in_tx ? PSTR("MS TX") : PSTR("MS"));
+  ui::PrintLine(5, b);
+  ui::Flush();
+  hang.magic = 0;
+  ubitx::ActiveDelay(3000);
+}
+
+}  // namespace
@@ -0,0 +1,47 @@
+#ifndef UBITX_WATCHDOG_H_
+#define UBITX_WATCHDOG_H_
+
+#include <avr/wdt.h>
+
+namespace watchdog {
+
+/**
+ * Hardware watchdog in interrupt and reset mode. Every scheduler pass
+ * feeds it. If no feed comes for TIMEOUT_MS the interrupt drops TX_RX
+ * and CW_KEY and notes which task hung and for how long, the next
+ * timeout resets the cpu. So a hang keys the transmitter for at most
+ * TIMEOUT_MS and the radio is back in receive after twice that.
+ * The note survives the reset and is shown at the next boot.
+ */
+const unsigned int TIMEOUT_MS = 250;
+
+struct Hang {
+  unsigned int magic;        // set by the interrupt, cleared if no reset came
+  char task[5];             // name of the task that was running, "" for none
+  unsigned int ms;          // how long it had been running
+  bool in_tx;
+};
+
+extern Hang hang;           // valid after a watchdog reset only
+
+void Init();
+void Disable();
+bool WasReset();            // the last reset came from the watchdog
+void Report();
+
+inline void Feed() {
+  wdt_reset();
+}
+
+// The first timeout clears WDIE, so the next one would reset without the
+// interrupt. Once a task has returned after all, arm the interrupt again
+// and drop the note, that hang did not end in a reset.
+inline void Rearm() {
+  if (WDTCSR & _BV(WDIE)) return;
+  hang.magic = 0;
+  WDTCSR |= _BV(WDIE);
+}
+
+}  // namespace
+
+#endif  // UBITX_WATCHDOG_H_